@@ -12,15 +12,39 @@
 
     An expression is input as a string and parsed into its separated terms;
     the terms are stored in a string array.
+    The terms are then compiled once into register bytecode: a list of
+    instructions, each of which writes its own result register and reads the
+    registers of earlier instructions. Constants are stored as doubles and
+    variables as slots which are bound when variables are substituted.
     Variables are represented by the Variable class and are input separately.
-    The expressions are then evaluated recursively for all values of all input
-    variables and the results stored in a double array.
+    Functions (sin, max, ...) are looked up and evaluated through the
+    FunctionRegistry.
+    The bytecode is evaluated for all values of all input variables, as a
+    grid in which the first variable turns slowest and the last fastest, and
+    the results stored in a double array. Instructions which
+    do not depend on the innermost variable are evaluated in the loops of the
+    outer variables they depend on, rather than at every point.
+
+    The bytecode may also be evaluated with interval arithmetic: given an
+    interval for each variable, it bounds the values of the expression over
+    all of their combinations, and flags the bounds if a math error may
+    occur in them.
+
+    At a single point, the bytecode may be evaluated with dual numbers: each
+    register carries its value and its derivatives with respect to two of
+    the variables (the axes of a plot), computed by the chain rule in the
+    same pass as the value. Likewise, the derivative with respect to one
+    variable may be bounded over intervals of the variables, e.g. to find
+    that the expression is monotonic in it.
 
     Problems arising from a mathematically incorrect expression are flagged
     during parsing. The position of problem terms are logged in an integer array.
     Problems arising from a mathematical operation (e.g. divide by 0) are flagged
-    during evaluation. The index of problem evaluations are logged in an integer
-    array.
+    during evaluation without interrupting it: the values carry on as NaN or
+    infinity and the first error of each point is kept in a byte array. The
+    result of a point with an error is 0, as it was when errors interrupted
+    the evaluation of the point. The index of problem evaluations are logged
+    in an integer array.
 */
 
 #ifndef EXPRESSION_H
@@ -32,18 +56,22 @@
 #include<stdlib.h>
 #include<string>
 #include<vector>
+#include<unordered_map>
+#include<algorithm>
 #include<sstream>
 #include<cassert>
 #include<locale.h>
 #include<math.h>
 #include<iostream>
 #include"variable.h"
+#include"mathkernels.h"
+#include"functionregistry.h"
 
 ///	Preprocessor Definitions
 ///	=========================
 
-    #ifndef COMPRESSION_CHAR
-    #define COMPRESSION_CHAR '$'
+    #ifndef BATCH_SIZE
+    #define BATCH_SIZE 256
     #endif
 
     #ifndef PI
@@ -51,6 +79,12 @@
     #endif
 
 
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
 ///	Enumerated Types
 ///	=================
 
@@ -59,27 +93,70 @@
         UninitializedCounter = -1,
     };
 
-    enum MathErrorCode
-    {
-        MathDivideByZero	= 200,
-        MathNaN,
-        MathPole,
-        MathComplex,
-    };
-
     enum InputErrorCode
     {
         InputErrorUninitializedVariable	= 300,
         InputErrorInvalidExpression,
         InputErrorParenthesesEmpty ,
         InputErrorParenthesesNotEmpty,
+        InputErrorArgumentCount,
     };
 
+    enum OpCode
+    {
+        OpConstant = 0,
+        OpVariable,
+        OpNegate,
+        OpAdd,
+        OpSubtract,
+        OpMultiply,
+        OpDivide,
+        OpPower,
+        OpSquareRoot,
+        OpFunction,
+    };
 
-///	Namespaces
-///	===========
+    enum OperatorPrecedence
+    {
+        PrecedenceNone = 0,
+        PrecedenceAddition,
+        PrecedenceSubtraction,
+        PrecedenceMultiplication,
+        PrecedenceDivision,
+        PrecedencePower,
+    };
 
-using namespace std;
+
+///	Structs
+///	========
+
+    struct Instruction
+    {
+        OpCode code;
+        int lhs;		// register of the first operand
+        int rhs;		// register of the second operand
+        int function;	// FunctionCode of OpFunction
+        int slot;		// variable slot of OpVariable, bound in subVariableValues
+        int term;		// originating term, used for error reporting
+        double value;	// value of OpConstant
+    };
+
+    struct DualNumber
+    {
+        double value;
+        double dx;		// derivative with respect to the first variable of evaluateDual
+        double dy;		// derivative with respect to the second
+    };
+
+    struct BatchSpan
+    {
+        const double *values;		// value of the variable at the first point
+        int stride;					// distance between values, 0 broadcasts the first value
+        const Variable *variable;	// if set, the values are computed from its domain instead
+    };
+
+
+    struct JitProgram;	// jitcompiler.h
 
 
 ///	Class
@@ -92,7 +169,7 @@ public:
 
     //	setters
     void setExpression(string expression);
-    void addVariable(Variable variable);
+    void addVariable(const Variable &variable);
     void clearVariables();
     void setCancelPointer(bool *ptr);
 
@@ -101,9 +178,9 @@ public:
     string getExpression();
     string getTerm(int term_pos);
     string getErrors();
-    vector<int> getProblemElements_Expression();
-    vector<int> getProblemElements_Result();
-    bool isXBeforeY(Variable x_variable, Variable y_variable);
+    const vector<int> &getProblemElements_Expression();
+    const vector<int> &getProblemElements_Result();
+    const vector<int> &getResultStrides();
 
     //	parsing
     vector<string> parseExpressionArray(string expression);
@@ -111,12 +188,19 @@ public:
 
     //	evaluation
     void subVariableValues();
-    vector<double> evaluateAll();
+    const vector<double> &evaluateAll();
+    const vector<double> &evaluateDependent();
+    void prepareBatches();
+    double estimateCost();
+    Interval evaluateInterval(const vector<Interval> &variables);
+    Interval evaluateSlope(const vector<Interval> &variables, int slot);
+    DualNumber evaluateDual(const vector<double> &variables, int x_slot, int y_slot, PointError &error);
+    void evaluateBatch(const vector<BatchSpan> &variables, int count, double *results, PointError *errors);
 
     //	validation
     bool isValid();
     bool charIsValid(char);
-    bool variableNameIsValid(Variable&);
+    bool variableNameIsValid(const Variable&);
 
     //	static
     static bool approxEqual(double dNum1, double dNum2, double dPrec){
@@ -128,19 +212,40 @@ private:
     // - meta
     int m_TermCount;
     int m_VariableCount;
-    int m_CurrentVariable;
 
     // - data
     vector<string> m_OriginalExpression;
-    vector<string> m_WorkingExpression;
+    vector<Instruction> m_SourceProgram;	// as compiled, before simplification
+    vector<Instruction> m_Program;			// as evaluated
+    vector<double> m_BatchRegisters;
+    vector<double> m_SlotValues;
+    int m_InnerCount;					// values of the innermost variable in the results
+    vector<BatchSpan> m_Spans;
+    vector<int> m_Levels;				// loop level of each instruction
+    vector<PointError> m_HoistedErrors;	// math error of each hoisted instruction
+    vector<bool> m_LevelNonFinite;		// a hoisted value up to the level is not finite
+    bool flag_Hoisted;					// instructions of the outer levels are hoisted out of the batches
+    bool flag_FiniteInputs;				// constants and variables are finite, see canSampleExceptions
+    const JitProgram *m_JitProgram;		// native code of m_Program, 0 to interpret
+    vector<double> m_JitInputs;
+    vector<const double*> m_JitVariables;
     vector<Variable> m_Variables;
+    unordered_map<string, int> m_VariableSlots;	// position of each variable in m_Variables, by name
     vector<double> m_Results;
+    vector<int> m_Extents;				// values of each variable in the results
+    vector<int> m_ResultStrides;		// distance between its values in the results, 0 if not evaluated
     vector<int> m_Results_Problems;
-    bool flag_XBeforeY;
+    vector<PointError> m_ResultErrors;	// errors of the current innermost batch
+    vector<Interval> m_IntervalRegisters;
+    vector<Interval> m_SlopeRegisters;	// bounds of the derivatives, see evaluateSlope
+    vector<double> m_DualValues;
+    vector<double> m_DualDx;
+    vector<double> m_DualDy;
 
     // - error handling
     bool flag_Valid;
     int m_ProblemTerm;
+    int m_LastParenthesis;	// opening term of the parentheses compiled last
     string m_ErrorMessage;
     vector<int> m_Expression_Problems;
 
@@ -155,6 +260,7 @@ private:
     // - parsing
     bool charIsDigit		(char c);
     bool charIsParenthesis	(char c);
+    bool charIsSeparator	(char c);
     bool charIsOperator		(char c);
     bool charIsAlpha		(char c);
     bool charIsWhitespace	(char c);
@@ -165,30 +271,57 @@ private:
     bool check_NumbersOK		(string term);
     bool check_CharsOK			(string term);
     bool check_OperatorsOK		(string term, int term_pos, int last_term_pos, bool &flag_prev_operator);
-    bool variableNameIsUnique(Variable &variable);
+    bool variableNameIsUnique(const Variable &variable);
+    int variableSlot(const string &name);
     bool termIsNumeric		(string term);
     bool termIsAlpha		(string term);
     bool termIsFunction		(string term);
     bool termIsStandardValue(string term);
 
-    // - expression reduction
-    bool compressExpression	(vector<string> &expression);
-    bool doParenthesis		(vector<string> &expression);
-    bool doPowers			(vector<string> &expression);
-    bool doDivision			(vector<string> &expression);
-    bool doMultiplication	(vector<string> &expression);
-    bool doSubtraction		(vector<string> &expression);
-    bool doAddition			(vector<string> &expression);
-    void doBasic(vector<string>&);
-    void doSpecial(vector<string>&, int, bool);
-
-    // - recursive evaluation
-    void recEval();
-    double evaluateExpression();
-    void resetExpression();
+    bool termIsOperator		(string term);
+    bool termIsOperand		(string term);
+
+    // - compilation
+    void compileExpression();
+    int emitInstruction		(OpCode code, int lhs = -1, int rhs = -1, int term = -1);
+    int emitConstant		(double value, int term);
+    int compileOperand		(int term);
+    int parseExpression		(int &pos, int min_precedence);
+    int parseOperand		(int &pos);
+    int parseFunction		(int &pos, FunctionCode function, int function_term);
+
+    // - simplification
+    void simplifyProgram();
+    int simplifyInstruction	(Instruction instruction);
+    bool isConstant			(int reg);
+    bool isConstant			(int reg, double value);
+    void eliminateDeadInstructions(int result);
+
+    // - grid evaluation
+    const vector<double> &evaluateProduct(bool flag_dependent_only);
+    void evaluateGrid();
+    void computeLevels();
+    void evaluateLevel(int level);
+    bool isHoisted(int i);
+    void evaluateBlock(const vector<BatchSpan> &variables, int start, int count, double *results, PointError *errors);
+    bool canSampleExceptions();
+    bool inputsAreFinite();
+    void interpretBlock(const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify);
+    void evaluateInstruction(int i, const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify);
+    bool evaluateBlockNative(const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify);
+    void validateBlockNative(const vector<BatchSpan> &variables, int start, int count, double *results, PointError *errors);
+    void applyHoistedError(int i, PointError *errors, int count);
+    double evaluateScalar(const Instruction &instruction, const double *reg, const double *slot_values, PointError &error);
+    Interval boundInstruction(const Instruction &instruction, const Interval *reg, const vector<Interval> &variables);
+    static Interval boundPower(const Interval &base, const Interval &exponent);
+    static Interval boundArithmetic(OpCode code, const Interval &a, const Interval &b);
+    Interval boundSlope(int i, int slot);
+    void differentiateInstruction(int i, int x_slot, int y_slot);
+    static bool isInteger(double value);
 
     // - internal getters
     string getStringArray(vector<string> string_array);
+    string getJitKey();
 
     // - exceptions and error handling
     void handleMathException(MathErrorCode);
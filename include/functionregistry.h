@@ -0,0 +1,168 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    functionregistry.h
+    -------------------
+
+    Description
+    ============
+    Lists the functions which may be called in an expression, e.g. sin(x) or
+    max(x, y). Each function has a single entry in the registry which holds:
+    - its name and number of arguments
+    - a scalar implementation, evaluating a single point
+    - a batch implementation, evaluating a block of points; these are either
+      loops written to be auto-vectorized or the kernels of MathKernels
+    - a domain check, flagging the points of a block where the function is
+      not defined (poles, complex results); NaN results are always flagged
+    - a rough cost per point, used to order the evaluation of inequalities
+
+    Functions may also be bounded over intervals of their arguments, for the
+    interval evaluation of expressions. Functions without bounds give an
+    unbounded interval, which never decides a comparison. They are also
+    differentiated, for the evaluation of expressions with dual numbers,
+    and the derivatives of the common functions bounded over intervals.
+
+    Names are mapped to FunctionCodes through a hash which is computed at
+    compile time for the names in the registry; lookup switches over these
+    hashes, so two names with the same hash fail to compile instead of
+    calling the wrong function.
+
+    To add a function: add its FunctionCode, its entry in s_entries and its
+    case in lookup, its case in derivative, and if it can be bounded, its
+    cases in bound and boundDerivative.
+*/
+
+#ifndef FUNCTIONREGISTRY_H
+#define FUNCTIONREGISTRY_H
+
+///	Includes
+///	=========
+
+#include<string>
+#include<math.h>
+
+
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
+///	Enumerated Types
+///	=================
+
+    enum MathErrorCode
+    {
+        MathDivideByZero	= 200,
+        MathNaN,
+        MathPole,
+        MathComplex,
+    };
+
+    enum FunctionCode
+    {
+        FunctionNone = -1,
+        FunctionSin,
+        FunctionCos,
+        FunctionTan,
+        FunctionSec,
+        FunctionCsc,
+        FunctionCot,
+        FunctionSinh,
+        FunctionCosh,
+        FunctionTanh,
+        FunctionSech,
+        FunctionCsch,
+        FunctionCoth,
+        FunctionArcsin,
+        FunctionArccos,
+        FunctionArctan,
+        FunctionArcsec,
+        FunctionArccsc,
+        FunctionArccot,
+        FunctionArcsinh,
+        FunctionArccosh,
+        FunctionArctanh,
+        FunctionArcsech,
+        FunctionArccsch,
+        FunctionArccoth,
+        FunctionExp,
+        FunctionLn,
+        FunctionLog,
+        FunctionMin,
+        FunctionMax,
+        FunctionAbs,
+        FunctionSqrt,
+        FunctionCount,		// number of functions in the registry
+    };
+
+
+///	Structs
+///	========
+
+    typedef unsigned char PointError;	// 0, or 1 + (MathErrorCode - MathDivideByZero)
+
+    inline PointError pointError(MathErrorCode e) { return static_cast<PointError>(1 + e - MathDivideByZero); }
+
+    inline MathErrorCode mathError(PointError error) { return static_cast<MathErrorCode>(MathDivideByZero + error - 1); }
+
+    struct Interval
+    {
+        double lower;
+        double upper;
+        bool flag_error;	// a value in the interval may have a math error, or the bounds are not known
+    };
+
+    inline Interval makeInterval(double lower, double upper, bool flag_error = false)
+    {
+        Interval interval = { lower, upper, flag_error };
+        return interval;
+    }
+
+    inline Interval unboundedInterval() { return makeInterval(-INFINITY, INFINITY, true); }
+
+    // rhs is unused by functions of one argument
+    typedef double (*ScalarFunction)(double lhs, double rhs);
+    typedef void (*BatchFunction)(const double *lhs, const double *rhs, double *results, int count);
+    typedef void (*DomainCheck)(const double *lhs, const double *rhs, const double *results, PointError *errors, int count);
+
+    struct FunctionEntry
+    {
+        const char *name;
+        int arity;				// number of arguments
+        ScalarFunction scalar;
+        BatchFunction batch;
+        DomainCheck domain;		// 0 if only NaN results are errors
+        int cost;				// estimated time per point, in additions
+    };
+
+
+///	Class
+/// ======
+
+class FunctionRegistry
+{
+public:
+    //	lookup
+    static FunctionCode lookup(const string &name);
+    static bool isFunction(const string &name);
+    static const FunctionEntry &entry(int function);
+
+    //	evaluation
+    static double evaluate(int function, double lhs, double rhs, PointError &error);
+    static void evaluate(int function, const double *lhs, const double *rhs, double *results, PointError *errors, int count);
+    static Interval bound(int function, const Interval &lhs, const Interval &rhs);
+    static void derivative(int function, double lhs, double rhs, double value, double &d_lhs, double &d_rhs);
+    static void boundDerivative(int function, const Interval &lhs, const Interval &rhs, const Interval &value, Interval &d_lhs, Interval &d_rhs);
+
+    //	hashing
+    static constexpr unsigned int hashName(const char *name, unsigned int hash = 2166136261u){
+        return (*name == 0) ? hash : hashName(name + 1, (hash ^ static_cast<unsigned char>(*name)) * 16777619u);
+    }
+
+private:
+    static const FunctionEntry s_entries[FunctionCount];
+};
+
+#endif // FUNCTIONREGISTRY_H
@@ -10,8 +10,36 @@
     Stores expressions and symbol required to represent an inequality.
 
     Provides methods to:
-    - compare results of expression evaluation and return boolean array
-      of the comparison results.
+    - compare results of expression evaluation and return the comparison
+      results as a Region, with the points of math errors flagged and the
+      difference of the sides kept as the field of the region. Each
+      side is evaluated only over the variables it references and
+      broadcast over the others. Given a mask of the points which can
+      still change a combination, only those points are compared.
+    - optionally bound the two sides over rectangles of the grid with
+      interval arithmetic first (see setEvaluation): a rectangle in which
+      the comparison holds or fails everywhere is decided at once, and
+      others are split into quarters; only the points of the small
+      rectangles left undecided are compared one by one. Before that, the
+      columns of the grid in which the comparison is monotonic in y (from
+      bounds of its derivative) hold in a run of rows from one end, which is
+      found by bisection rather than by comparing every row
+    - optionally refine the boundary of the region (see setRefinementDepth):
+      the cells of the grid whose corners differ are split into quarters,
+      and only the quarters whose corners still differ are split again, up
+      to the depth; the sub-points are kept as the cells of the region
+    - estimate the cost of a comparison and the part of the grid in which
+      the inequality holds, to order the evaluation of combinations
+    - evaluate the field and its gradient at any point of the plot, from
+      the dual numbers of the two sides: to project a point of the boundary
+      sampled on the grid onto the curve on which the sides are equal
+      (Newton's method along a side of a cell), and to give the slack of a
+      point, its distance from that curve to first order
+    - lay the comparison results out as a row-major grid: once setGrid is
+      called, x is the innermost loop (the columns of the region) and y the
+      next (its rows). Other variables are outermost, in the order in which
+      they were added, and should have a single value: with more, the rows
+      of the region repeat for each of their values.
     - handle validation outputs from the Expression class
 */
 
@@ -27,6 +55,7 @@
 #include<cassert>
 #include"variable.h"
 #include"expression.h"
+#include"region.h"
 
 
 /// Enumerated Types
@@ -41,6 +70,22 @@ enum InequalitySymbol{
     ApproxEqual,
 };
 
+enum InequalityEvaluation{
+    EvaluationGrid		= 0,	// compare every point
+    EvaluationIntervals,		// decide rectangles from interval bounds first
+};
+
+
+///	Structs
+///	========
+
+struct SubCell
+{
+    int cell;		// boundary cell being refined
+    int i, j;		// first sub-point of the part of the cell
+    int size;		// sub-points per side of the part
+};
+
 
 ///	Namespaces
 ///	===========
@@ -64,44 +109,85 @@ private:
     int m_Symbol;
 
     // evaluation
-    vector<double> m_LeftResults, m_RightResults;
+    vector<Variable> m_Variables;
+    vector<int> m_Order;		// variables from the outermost loop to the innermost
     double m_Precision;
     string m_ErrorMessage;
+    static InequalityEvaluation s_evaluation;
+    static const int s_leafSize = 8;	// rectangles of at most this size are not split
+    static int s_refinementDepth;
+    static const int s_refinementChunk = 4096;	// boundary cells refined together
+    static const int s_projectionSteps = 20;		// most Newton steps of projectOnBoundary
+    static const int s_slopeDepth = 4;				// most halvings of the range of y in slopeSign
+    vector<double> m_PointValues;	// values of the variables at the point of fieldGradient
+
+    bool compare(double left, double right);
+    vector<bool> problemFlags(const vector<int> &problem_points, int size);
+    Region createRegion();
+    bool maskIsSparse(const Region &mask);
+    void evaluateMasked(const Region &mask, Region &region);
+    Region evaluateRegion(const Region *mask);
+    Region evaluatePoints(const Region *mask);
+    Region bisectColumns(Region &region, const Region *mask);
+    int slopeSign(vector<Interval> &bounds, int slot, double lower, double upper, int depth);
+    Interval fieldSlope(const vector<Interval> &bounds, int slot);
+    void comparePointList(const vector<int> &columns, const vector<int> &rows, Region &region);
+    void comparePoints(const vector<BatchSpan> &spans, int count, const int *columns, const int *rows, Region &region);
+    void compareBatch(const vector<BatchSpan> &spans, int count, bool *flag_holds, bool *flag_problems, float *field = 0);
+    float fieldValue(double left, double right);
+    bool fieldGradient(double x, double y, DualNumber &field);
+    bool canBoundCells(const Region &region);
+    Region boundCells(Region &region, const Region *mask);
+    void refineCell(int first_column, int first_row, int columns, int rows, vector<Interval> &bounds, const Region *mask, Region &region, Region &undecided);
+    int compareIntervals(const Interval &left, const Interval &right);
+    void refineBoundary(Region &region, const Region *mask);
+    vector<int> boundaryCells(const Region &region, const Region *mask);
+    void refineCells(Region &region, const vector<int> &cells, int first, int last);
 
 public:
     Inequality(string expression1 = "", InequalitySymbol symbol = NoSymbol, string expression2 = "");
 
     //	setters
     void clearVariables();
-    void addVariable(Variable variable);
+    void addVariable(const Variable &variable);
+    void setGrid(const Variable &x_variable, const Variable &y_variable);
     void setInequality(string left_expression, int symbol, string right_expression);
     void setInequality(string left_expression, InequalitySymbol symbol, string right_expression);
     void changeSymbol(int symbol);
     void changeSymbol(InequalitySymbol symbol);
     void setPrecision(double value);
     void setCancelPointer(bool *ptr);
+    static void setEvaluation(InequalityEvaluation evaluation);
+    static void setRefinementDepth(int depth);
 
     //	getters
-    vector<int> getProblemElements_ExpressionLHS();
-    vector<int> getProblemElements_ExpressionRHS();
+    const vector<int> &getProblemElements_ExpressionLHS();
+    const vector<int> &getProblemElements_ExpressionRHS();
     string getTermLHS(int nTerm);
     string getTermRHS(int nTerm);
     string getExpressionLHS();
     string getExpressionRHS();
     int getNumTermsLHS();
     int getNumTermsRHS();
-    bool getXBeforeY(Variable mXVar, Variable mYVar);
+    static InequalityEvaluation evaluation();
+    static int refinementDepth();
 
 
     //	evaluation
-    vector<bool> evaluate();
-    vector<int> getProblemElements_ResultsCombined();
+    Region evaluate(const Region *mask = 0);
+    double estimateCost();
+    double estimateSelectivity(int samples = 1024);
+
+    //	boundary
+    void prepareBoundary();
+    bool projectOnBoundary(double x0, double y0, double x1, double y1, double &fraction);
+    double slack(double x, double y, double x_scale, double y_scale);
 
     //	validation
     bool isValidLHS();
     bool isValidRHS();
     bool variablesInit();
-    bool variableIsValid (Variable & myVar);
+    bool variableIsValid (const Variable &myVar);
     string getErrors();
 
 }; // Inequality
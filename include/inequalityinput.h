@@ -70,7 +70,8 @@ enum ComboboxShape {
     DownTriangle,
     Square,
     Diamond,
-    Dots
+    Dots,
+    Filled
 };
 
 
@@ -87,6 +88,9 @@ class InequalityInput;
 
 static string s_combinations [] = { "none", "intersection", "union", "subtraction" };
 
+// like Dots, Filled is drawn without a symbol: the boundary of the region is filled
+static const QwtSymbol::Style s_filledStyle = static_cast<QwtSymbol::Style>(QwtSymbol::UserStyle + 1);
+
 
 ///	Class
 ///	======
@@ -101,9 +105,8 @@ public:
 
     //	setters
     void setNumber(int);
-    void setXYVariables(Variable, Variable);
-    void setX(QVector<double>);
-    void setY(QVector<double>);
+    void setXYVariables(const Variable&, const Variable&);
+    void setRegion(const Region&);
     void enablePositionButtons(bool);
     void enableCombinations(bool);
     void resetCombinations();
@@ -112,7 +115,6 @@ public:
     // 	parsers
     string expressionToJSON();
     string dataToJSON();
-    string problemDataToJSON();
     void fromJSON(string);
     InequalitySymbol symbolFromString(string value);
 
@@ -135,10 +137,10 @@ public:
     void clearLineEditTextFormat(QLineEdit* lineEdit); /*! Vasaka*/
 
     //	getters: data
-    QVector<double> getX();
-    QVector<double> getY();
-    QVector<double> getXProblem();
-    QVector<double> getYProblem();
+    const Region &getRegion();
+    Inequality &getInequality();
+    double getCost();
+    double getSelectivity();
 
     //	validation
     bool highlightInvalidExpressionTerms();
@@ -150,8 +152,8 @@ public:
 
     //	core
     bool createInequality();
-    bool addVariable(Variable variable);
-    bool evaluate();
+    bool addVariable(const Variable &variable);
+    bool evaluate(const Region *mask = 0);
 
 signals:
     void moveUp(int gui_number);
@@ -185,10 +187,8 @@ private:
     int m_precisionIndex;
     bool flag_skip;
 
-    // result vectors
-    vector<bool> m_points;
-    vector<int> m_points_problem;
-    QVector<double> m_x, m_y, m_x_problem, m_y_problem;
+    // results
+    Region m_region;
 
     // error handling
     QString m_errorMessage;
@@ -76,8 +76,7 @@ public:
     void setNumber(int number);
     void setCaseName(QString value);
     void loadCase(QString filename);
-    void setX(QVector<double> vector);
-    void setY(QVector<double> vector);
+    void setRegion(const Region &region);
     void clearCombinationResults();
     void createDetailItem(int level, QString type, QString desc, QString data1, QString data2);
 
@@ -94,10 +93,9 @@ public:
     QwtSymbol::Style getShape();
 
     //	getters: data
-    QVector<double> getX();
-    QVector<double> getY();
-    QVector<double> getXProblem();
-    QVector<double> getYProblem();
+    const Region &getRegion();
+    double getCost();
+    double getSelectivity();
     QString getFile();
     QString getErrors();
 
@@ -107,7 +105,7 @@ public:
     void parseProblem(QString problem);
 
     void formatPlot();
-    void formatVariables(QString json);
+    void formatVariables(QString json, bool flag_grid = false);
     void formatInequality(QString json);
     void formatCase(QString json);
     void formatExpressions(QString json);
@@ -148,9 +146,10 @@ private:
     Ui::InequalityLoader *ui;
 
     //	data
-    QList< QVector<double> > m_xResults, m_yResults;
-    QList< QVector<double> > m_xResults_Problem, m_yResults_Problem;
-    QVector<double> m_xResults_combination, m_yResults_combination;
+    QList<Region> m_regions;
+    Region m_regionCombination;
+    bool flag_combined;
+    Variable m_xVariable, m_yVariable;		// grid of the plots
     QStringList m_expressions;
     QList<DetailItem> m_details;
 
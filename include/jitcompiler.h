@@ -0,0 +1,129 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    jitcompiler.h
+    --------------
+
+    Description
+    ============
+    Compiles the register bytecode of an Expression to native x86-64 code.
+
+    The arithmetic instructions (constants, variables, negation, addition,
+    subtraction, multiplication, division and square roots) are fused into
+    segments: each segment is one native loop over a block of points which
+    keeps its values in SSE2 registers, two points at a time. Powers and functions are left to the
+    bytecode interpreter, as are segments which would need more registers than
+    are available; these split the program into several segments. Values which
+    cross from one segment to another are passed through the batch registers of
+    the Expression.
+
+    When a grid is evaluated, the instructions which do not depend on its
+    innermost variable are hoisted out of the batches (see Expression). A
+    second set of segments is compiled for this: hoisted instructions are left
+    out of them and their values read from the batch registers instead, so
+    they are not computed again for every block.
+
+    A segment is called as
+        int segment(double *registers, const double *const *variables, int count);
+    where registers are the batch registers (BATCH_SIZE doubles per
+    instruction), variables[slot] points to count contiguous values of each
+    variable, and the return value is non-zero if a division or square root
+    gave a non-finite value.
+
+    Code is written into mmap'd memory which is made executable once complete.
+    Compiled programs are cached for the lifetime of the process, keyed by the
+    normalized expression text and its variable slots, so expressions which are
+    re-plotted are not recompiled. Once the cache is full, new expressions are
+    interpreted.
+
+    Only x86-64 unix builds have the compiler; elsewhere compile returns 0 and
+    all expressions are interpreted.
+*/
+
+#ifndef JITCOMPILER_H
+#define JITCOMPILER_H
+
+///	Includes
+///	=========
+
+#include<string>
+#include<vector>
+#include<map>
+#include"expression.h"
+
+
+///	Preprocessor Definitions
+///	=========================
+
+    #if defined(__x86_64__) && defined(__unix__)
+    #define JITCOMPILER_NATIVE
+    #endif
+
+    #ifndef JIT_CACHE_SIZE
+    #define JIT_CACHE_SIZE 1024
+    #endif
+
+
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
+///	Enumerated Types
+///	=================
+
+    enum JitMode
+    {
+        JitOff	= 0,	// interpret all expressions
+        JitOn,			// run compiled code where available
+        JitValidate,	// run compiled code and check it against the interpreter
+    };
+
+
+///	Structs
+///	========
+
+    typedef int (*JitSegment)(double *registers, const double *const *variables, int count);
+
+    struct JitStep
+    {
+        int first;			// first instruction of the step
+        int last;			// one past the last instruction of the step
+        JitSegment segment;	// native code, or 0 if instruction first is interpreted
+    };
+
+    struct JitProgram
+    {
+        vector<JitStep> steps;
+        vector<JitStep> hoisted_steps;	// steps of a grid, the hoisted instructions left out of the segments
+        void *code;			// executable memory holding the segments
+        size_t code_size;
+    };
+
+
+///	Class
+/// ======
+
+class JitCompiler
+{
+public:
+    //	settings
+    static void setMode(JitMode mode);
+    static JitMode mode();
+    static string modeName(JitMode mode);
+    static bool modeFromName(string name, JitMode &mode);
+    static bool isSupported();
+
+    //	compilation
+    static const JitProgram *compile(const string &key, const vector<Instruction> &program, int inner_slot);
+
+private:
+    static JitMode s_mode;
+    static map<string, JitProgram*> s_cache;
+
+    static JitProgram *compileProgram(const vector<Instruction> &program, int inner_slot);
+};
+
+#endif // JITCOMPILER_H
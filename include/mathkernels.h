@@ -0,0 +1,152 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    mathkernels.h
+    --------------
+
+    Description
+    ============
+    Evaluates the functions supported by Expression over whole arrays of values.
+
+    Two accuracy modes are provided:
+    - AccuracyExact	calls the C math library for every value.
+    - AccuracyFast	uses branch-free polynomial and rational approximations
+                    which the compiler vectorizes. Values outside of the fast
+                    domain of a kernel are passed on to the math library.
+
+    Maximum errors of the fast kernels in units in the last place (ULP),
+    measured over 1.6e8 random arguments, and next to the multiples of pi/2
+    and the ends of the domains, against a long double reference:
+
+        kernel		fast domain				max error
+        -------		------------			----------
+        exp			all values				1.2 ULP
+        ln			all values				0.9 ULP
+        log			all values				1.9 ULP
+        sin, cos	|x| <= 1e5				2.5 ULP		(1.5 ULP for |x| <= 4)
+        tan			|x| <= 1e5				3.9 ULP		(2.9 ULP for |x| <= 4)
+        sinh		|x| <= 709				2.2 ULP
+        cosh		|x| <= 709				1.6 ULP
+        tanh		all values				2.5 ULP
+        arcsin		all values				2.3 ULP
+        arccos		all values				1.2 ULP
+        arctan		all values				0.9 ULP
+        arcsinh		all values				2.7 ULP
+        arccosh		all values				2.6 ULP
+        arctanh		all values				2.9 ULP
+
+    Arguments outside of the fast domain of a kernel, as well as 0, infinite
+    and NaN arguments, give the same results as the math library.
+
+    The input and output arrays must not overlap.
+
+    The fast kernels are compiled for several instruction sets (SSE2, AVX2
+    with FMA, AVX-512) in the same binary; the widest one the CPU supports is
+    selected at startup, and may be overridden with setIsa. The errors above
+    hold for all instruction sets.
+*/
+
+#ifndef MATHKERNELS_H
+#define MATHKERNELS_H
+
+///	Includes
+///	=========
+
+#include<math.h>
+#include<string.h>
+#include<stdint.h>
+#include<string>
+
+
+///	Preprocessor Definitions
+///	=========================
+
+    // runtime selection of the instruction set is only done for x86 with GCC/Clang
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define MATHKERNELS_DISPATCH
+    #endif
+
+
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
+///	Enumerated Types
+///	=================
+
+enum KernelAccuracy
+{
+    AccuracyExact	= 0,
+    AccuracyFast,
+};
+
+enum KernelIsa
+{
+    IsaSSE2		= 0,	// baseline of the build target
+    IsaAVX2,
+    IsaAVX512,
+};
+
+
+///	Structs
+///	========
+
+typedef void (*KernelLoop)(const double *x, double *y, int count);
+struct KernelTable;
+
+
+///	Class
+/// ======
+
+class MathKernels
+{
+public:
+    //	settings
+    static void setAccuracy(KernelAccuracy accuracy);
+    static KernelAccuracy accuracy();
+    static bool setIsa(KernelIsa isa);
+    static KernelIsa isa();
+
+    //	instruction sets
+    static bool isaSupported(KernelIsa isa);
+    static KernelIsa detectIsa();
+    static string isaName(KernelIsa isa);
+    static bool isaFromName(string name, KernelIsa &isa);
+
+    //	exponential and logarithmic
+    static void vectorExp	(const double *x, double *y, int count);
+    static void vectorLn	(const double *x, double *y, int count);
+    static void vectorLog	(const double *x, double *y, int count);
+
+    //	trig
+    static void vectorSin	(const double *x, double *y, int count);
+    static void vectorCos	(const double *x, double *y, int count);
+    static void vectorTan	(const double *x, double *y, int count);
+
+    //	hyperbolic
+    static void vectorSinh	(const double *x, double *y, int count);
+    static void vectorCosh	(const double *x, double *y, int count);
+    static void vectorTanh	(const double *x, double *y, int count);
+
+    //	inverse trig
+    static void vectorArcsin	(const double *x, double *y, int count);
+    static void vectorArccos	(const double *x, double *y, int count);
+    static void vectorArctan	(const double *x, double *y, int count);
+
+    //	inverse hyperbolic
+    static void vectorArcsinh	(const double *x, double *y, int count);
+    static void vectorArccosh	(const double *x, double *y, int count);
+    static void vectorArctanh	(const double *x, double *y, int count);
+
+private:
+    static KernelAccuracy s_accuracy;
+    static KernelIsa s_isa;
+    static const KernelTable *s_kernels;
+
+    static const KernelTable *kernelTable(KernelIsa isa);
+};
+
+#endif
@@ -47,6 +47,10 @@
 
 #include <qwt_plot.h>
 #include <qwt_plot_curve.h>
+#include <qwt_plot_shapeitem.h>
+#include <qwt_plot_spectrogram.h>
+#include <qwt_matrix_raster_data.h>
+#include <qwt_color_map.h>
 #include <qwt_symbol.h>
 #include <qwt_legend.h>
 #include <qwt_plot_renderer.h>
@@ -60,11 +64,15 @@
 #include "variable.h"
 #include "inequality.h"
 #include "expression.h"
+#include "mathkernels.h"
 #include "variableinput.h"
 #include "inequalityinput.h"
 #include "inequalityloader.h"
 #include "bluejson.h"
 #include "plotworker.h"
+#include "region.h"
+#include "regionseries.h"
+#include "regioncontour.h"
 #include "exportdialog.h"
 
 
@@ -82,7 +90,6 @@ enum UIMode {
 typedef vector<VariableInput*> VarInputArray;
 typedef vector<InequalityInput*> IneqInputArray;
 typedef vector<InequalityLoader*> IneqLoaderArray;
-typedef QVector<QPointF> PlottingVector;
 typedef QwtSymbol::Style PlotStyle;
 typedef std::numeric_limits<double> precDouble	;
 
@@ -175,8 +182,10 @@ public slots:
 
     void sendWorkerData();
     void setProgress(int value, QString message);
-    void addGraph(PlottingVector qwt_samples, PlotStyle shape, QColor color, QString tag = "");
-    void addErrorGraph(PlottingVector qwt_problem_samples);
+    void addGraph(Region region, PlotStyle shape, QColor color, QString tag = "");
+    void addFilledGraph(QList<QPolygonF> polygons, QColor color, QString tag);
+    void addOverlay(QVector<double> values, int columns, QRectF bounds);
+    void addErrorGraph(Region region);
     void registerMemberChanges(VarInputArray var_inputs,
                     IneqInputArray ineq_inputs,
                     IneqLoaderArray ineq_loaders);
@@ -199,6 +208,10 @@ private slots:
     void on_toolButton_Plot_clicked();
     void on_toolButton_AddInequalityLoader_clicked();
     void on_lineEdit_SettingsTolerance_editingFinished();
+    void on_comboBox_SettingsAccuracy_currentIndexChanged(int index);
+    void on_comboBox_SettingsEvaluation_currentIndexChanged(int index);
+    void on_comboBox_SettingsRefinement_currentIndexChanged(int index);
+    void on_comboBox_SettingsOverlay_currentIndexChanged(int index);
     void on_splitter_VariableHeader_splitterMoved(int pos, int index);
     void on_splitter_InequalityHeader_splitterMoved(int pos, int index);
     void on_lineEdit_PlotTitle_returnPressed();
@@ -5,11 +5,17 @@
 ///	=========
 
 #include <QObject>
+#include <QPolygonF>
+#include <QVector>
+#include <QRectF>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include "variableinput.h"
 #include "inequalityinput.h"
 #include "inequalityloader.h"
+#include "region.h"
+#include "regioncontour.h"
 
 
 ///	TypeDefs
@@ -18,10 +24,35 @@
 typedef vector<VariableInput*> VarInputArray;
 typedef vector<InequalityInput*> IneqInputArray;
 typedef vector<InequalityLoader*> IneqLoaderArray;
-typedef QVector<QPointF> PlottingVector;
 typedef QwtSymbol::Style PlotStyle;
 
 
+///	Enumerated Types
+///	=================
+
+enum PlotOverlay{
+    OverlayNone		= 0,
+    OverlaySlack,		// the distance of each point from the boundary of the region
+};
+
+
+///	Structs
+///	========
+
+struct PlotMember
+{
+    bool flag_loader;	// index is in m_inequalityLoaders, else in m_inequalityInputs
+    int index;
+};
+
+struct PlotStep
+{
+    PlotMember member;	// inequality evaluated in the step
+    int combination;	// with the region of the earlier steps; CombinationNone starts a new region
+    PlotMember plot;	// inequality which shows the region after the step, index -1 if none
+};
+
+
 ///	Class
 ///	======
 
@@ -32,12 +63,19 @@ public:
     explicit PlotWorker(QObject *parent = 0);
     void doWork();
     void setCancelPointer(bool *ptr);
+    static void setOverlay(PlotOverlay overlay);
+    static PlotOverlay overlay();
+
+    static const int s_overlaySamples = 256;	// most points of the overlay per side
+    static const int s_overlayRange = 8;		// slack at which the overlay saturates, in steps of the grid
 
 signals:
     void dataRequest();
     void progressUpdate(int value, QString message);
-    void newGraph(PlottingVector qwt_samples, PlotStyle shape, QColor color, QString tag);
-    void newErrorGraph(PlottingVector qwt_problem_samples);
+    void newGraph(Region region, PlotStyle shape, QColor color, QString tag);
+    void newFilledGraph(QList<QPolygonF> polygons, QColor color, QString tag);
+    void newOverlay(QVector<double> values, int columns, QRectF bounds);
+    void newErrorGraph(Region region);
     void logMessage(QString message);
     void memberChanges(VarInputArray var_inputs,
                     IneqInputArray ineq_inputs,
@@ -61,14 +99,13 @@ private:
     IneqLoaderArray m_inequalityLoaders;
 
     //	plotting
-    int m_prevCombination;
+    vector<PlotStep> m_plan;
     int m_lastMatch;
     Variable m_xVariable, m_yVariable;
-    PlottingVector m_results;
-    PlottingVector m_resultsProblem;
-    PlottingVector m_resultsCombined;
-    PlottingVector *m_findRange;
+    Region m_region;
+    vector<PlotMember> m_regionMembers;	// inequalities combined into m_region
     bool *flag_Cancel;
+    static PlotOverlay s_overlay;
 
     //	gui management
     int m_inequalityCount;
@@ -80,12 +117,25 @@ private:
     double m_compPrec;
 
     //! member functions
+    //	planning
+    void planWork();
+    void reorderRun(int first, int last, int combination);
+    double estimateRank(const PlotMember &member, int combination, QString &estimate);
+    int memberNumber(const PlotMember &member);
+
     //	evaluation and plotting
-    void plotNew(int gui_number);
-    void plotOld(int gui_number);
+    bool combineNew(const PlotStep &step);
+    bool combineOld(const PlotStep &step);
+    void plotMember(const PlotMember &member);
+    vector<ContourMember> contourMembers();
+    QList<QPolygonF> tracePolygons();
+    void plotOverlay();
+
+    template <typename input_type>
+    void plotResults(input_type *inequality, int gui_number);
 
     template <typename input_type>
-    void combineResults(input_type *inequality);
+    void combineResults(input_type *inequality, int combination);
 
     template <typename input_type>
     void combinationNone(input_type *inequality);
@@ -99,11 +149,11 @@ private:
     template <typename input_type>
     void combinationSubtraction(input_type *inequality);
 
-    PlottingVector createPlottingVector(QVector<double> x_values, QVector<double> y_values);
-    QVector<double> splitPlottingVectorX(PlottingVector points);
-    QVector<double> splitPlottingVectorY(PlottingVector points);
+    template <typename input_type>
+    const Region &alignedRegion(input_type *inequality, Region &resampled);
 
     //	notification
+    void logCombination(QString combination);
     void printError();
     void printWarning();
 
@@ -0,0 +1,195 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    region.h
+    ---------
+
+    Description
+    ============
+    Stores the points of a plot grid at which an inequality holds as bits:
+    one bit per point of the grid, and a parallel bit per point which is set
+    where the evaluation of the point had a math error (a problem point).
+
+    The grid is described by its x and y variables; point (column, row) lies
+    at (x(column), y(row)). Rows are stored one after the other, y outermost
+    and x innermost, and each row is padded to a whole number of words, so
+    rows can be read and combined a word at a time. The padding bits are
+    always 0. A region without a grid (width 0) is empty.
+
+    A region may also be refined along its boundary: the cell between point
+    (column, row) and the next point in x and y is then sampled on a finer
+    grid of refinement x refinement sub-points, stored as a RegionCell of
+    one word each for the points and the problem points. Sub-point (0, 0) is
+    the point of the grid itself. Cells which are not refined take the value
+    of their point, so regions of different refinements can be combined.
+
+    A region may also keep a field: a value per point of the grid which is
+    negative where the inequality holds and positive where it does not
+    (for an evaluated inequality, the difference of its sides), or NaN where
+    it is not known. The field places the boundary of the region between
+    the points of the grid (see RegionContour). Combining regions combines
+    their fields as the maximum (intersection) or minimum (union), so the
+    field of a combination changes sign on its boundary too.
+
+    Provides methods to:
+    - read and write single points, rectangles of points, or whole rows as
+      words
+    - count the points and problem points
+    - combine regions on the same grid (intersection, union, subtraction)
+      a word at a time
+    - refine cells of the grid, and combine refined regions
+    - keep a field of the points, and combine fields
+    - map a region onto another grid
+    - write the bits as run lengths, the format in which plots are saved
+*/
+
+#ifndef REGION_H
+#define REGION_H
+
+///	Includes
+///	=========
+
+#include<string>
+#include<vector>
+#include<sstream>
+#include<stdint.h>
+#include<cassert>
+#include<math.h>
+#include"variable.h"
+
+
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
+///	Typedefs
+///	=========
+
+    typedef uint64_t RegionWord;
+
+
+///	Structs
+///	========
+
+    struct RegionCell
+    {
+        int index;				// row*width + column of the point of the cell
+        RegionWord points;		// sub-point (i, j) of the cell is bit j*refinement + i
+        RegionWord problems;
+    };
+
+
+///	Class
+/// ======
+
+class Region
+{
+public:
+    static const int s_wordBits = 64;
+    static const int s_maxRefinement = 8;	// the sub-points of a cell fit in a word
+
+    Region();
+    Region(const Variable &x_variable, const Variable &y_variable, int height = -1);
+
+    //	grid
+    const Variable &xVariable() const { return m_xVariable; }
+    const Variable &yVariable() const { return m_yVariable; }
+    int width() const { return m_Width; }
+    int height() const { return m_Height; }
+    int wordsPerRow() const { return m_WordsPerRow; }
+    double x(int column) const;
+    double y(int row) const;
+    bool isEmpty() const { return m_Width == 0 || m_Height == 0; }
+    bool sameGrid(const Region &other) const;
+
+    //	points
+    bool contains(int column, int row) const { return testBit(m_Points, column, row); }
+    bool isProblem(int column, int row) const { return testBit(m_Problems, column, row); }
+    void setPoint(int column, int row, bool flag) { setBit(m_Points, column, row, flag); }
+    void setProblem(int column, int row, bool flag) { setBit(m_Problems, column, row, flag); }
+    void setRectangle(int first_column, int first_row, int columns, int rows);
+    bool containsAny(int first_column, int first_row, int columns, int rows) const;
+    int count() const;
+    int problemCount() const;
+
+    //	words
+    const RegionWord *pointRow(int row) const { return &m_Points[row*m_WordsPerRow]; }
+    const RegionWord *problemRow(int row) const { return &m_Problems[row*m_WordsPerRow]; }
+    RegionWord *pointRow(int row) { return &m_Points[row*m_WordsPerRow]; }
+    RegionWord *problemRow(int row) { return &m_Problems[row*m_WordsPerRow]; }
+
+    //	refinement
+    int refinement() const { return m_Refinement; }
+    void setRefinement(int refinement);
+    const vector<RegionCell> &cells() const { return m_Cells; }
+    void addCell(const RegionCell &cell);
+    RegionCell cell(int index, int refinement) const;
+    double subX(int column, int sub) const;
+    double subY(int row, int sub) const;
+
+    //	field
+    bool hasField() const { return !m_Field.empty(); }
+    void enableField();
+    double field(int column, int row) const;
+    const float *fieldRow(int row) const { return &m_Field[row*m_Width]; }
+    float *fieldRow(int row) { return &m_Field[row*m_Width]; }
+
+    //	combination
+    void intersect(const Region &other);
+    void unite(const Region &other);
+    void subtract(const Region &other);
+    void clip(const Region &mask);
+    void excludeProblems();
+    Region complement() const;
+
+    //	conversion
+    Region resampled(const Variable &x_variable, const Variable &y_variable, int height = -1) const;
+    static int nearestIndex(const Variable &variable, double value);
+
+    //	saving
+    string pointsToRuns() const { return toRuns(m_Points); }
+    string problemsToRuns() const { return toRuns(m_Problems); }
+    bool pointsFromRuns(const string &runs) { return fromRuns(runs, m_Points); }
+    bool problemsFromRuns(const string &runs) { return fromRuns(runs, m_Problems); }
+    string cellsToString() const;
+    bool cellsFromString(const string &cells);
+
+    //	bits
+    static int bitCount(RegionWord word);
+    static int lowestBit(RegionWord word);
+
+private:
+    Variable m_xVariable, m_yVariable;
+    int m_Width;
+    int m_Height;
+    int m_WordsPerRow;
+    vector<RegionWord> m_Points;
+    vector<RegionWord> m_Problems;
+    int m_Refinement;				// sub-points of a cell per side, 1 if not refined
+    vector<RegionCell> m_Cells;		// refined cells, by index
+    vector<float> m_Field;			// value of each point, row after row, empty if not kept
+
+    bool testBit(const vector<RegionWord> &bits, int column, int row) const;
+    void setBit(vector<RegionWord> &bits, int column, int row, bool flag);
+    int countBits(const vector<RegionWord> &bits) const;
+    void uniteProblems(const Region &other);
+    void combineCells(const Region &other, RegionWord (*combine)(RegionWord, RegionWord));
+    void combineField(const Region &other, float (*combine)(float, float));
+    float pointField(int index) const;
+    static float intersectFields(float a, float b) { return fmax(a, b); }
+    static float uniteFields(float a, float b) { return fmin(a, b); }
+    static float subtractFields(float a, float b) { return fmax(a, -b); }
+    static RegionWord intersectWords(RegionWord a, RegionWord b) { return a & b; }
+    static RegionWord uniteWords(RegionWord a, RegionWord b) { return a | b; }
+    static RegionWord subtractWords(RegionWord a, RegionWord b) { return a & ~b; }
+    static RegionWord cellMask(int refinement);
+    static RegionWord rescaledCell(RegionWord bits, int from, int to, bool flag_fill);
+    double subValue(const Variable &variable, int index, int sub) const;
+    string toRuns(const vector<RegionWord> &bits) const;
+    bool fromRuns(const string &runs, vector<RegionWord> &bits) const;
+};
+
+#endif // REGION_H
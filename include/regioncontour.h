@@ -0,0 +1,123 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    regioncontour.h
+    ----------------
+
+    Description
+    ============
+    Traces the boundary of a Region as closed polygons by marching squares,
+    so a region can be drawn as filled shapes whose size grows with its
+    perimeter rather than with its area.
+
+    Each cell between four neighbouring points of the grid is classified by
+    which of its corners are in the region, and the boundary crosses each
+    side of the cell with one corner in and one out. The crossing is placed
+    where the field of the region changes sign, by linear interpolation, or
+    in the middle of the side where the field is unknown. A cell with only
+    two opposite corners in the region is resolved by the field at its
+    centre. The grid is surrounded by points outside of the region, so every
+    polygon closes; along the edge of the grid the boundary runs through its
+    outermost points.
+
+    A refined region (see Region) is traced at the resolution of its cells:
+    the grid of samples has refinement samples per step of the grid, the
+    sub-points of the refined cells and the repeated points of the others.
+    The field is only known at the points of the grid, so the crossings of
+    the sides between sub-points are placed in their middle, unless they
+    are projected.
+
+    Given the inequalities combined into the region (its members), each
+    crossing is projected onto the curve on which the sides of the
+    inequality crossing the side are equal (see
+    Inequality::projectOnBoundary), so a coarse grid gives a boundary as
+    accurate as the evaluation. The projection is only made where a single
+    member changes between the two points of the side, and it stays on the
+    side, so the polygons are joined as without it. Loaded members, which
+    have no expressions, are not projected.
+
+    The polygons of holes are returned with the others: the region is their
+    inside under the even-odd fill rule.
+*/
+
+#ifndef REGIONCONTOUR_H
+#define REGIONCONTOUR_H
+
+///	Includes
+///	=========
+
+#include<vector>
+#include<utility>
+#include<unordered_map>
+#include<algorithm>
+#include"region.h"
+#include"inequality.h"
+
+
+///	Namespaces
+///	===========
+
+using namespace std;
+
+
+///	Structs
+///	========
+
+    struct ContourPoint
+    {
+        double x;
+        double y;
+    };
+
+    typedef vector<ContourPoint> ContourPolygon;
+
+    struct ContourMember
+    {
+        const Region *region;		// its own region, on the grid of the contour
+        Inequality *inequality;		// 0 if it cannot be projected onto
+    };
+
+
+///	Class
+/// ======
+
+class RegionContour
+{
+public:
+    RegionContour(const Region &region, const vector<ContourMember> &members = vector<ContourMember>());
+
+    static bool canTrace(const Region &region);
+    const vector<ContourPolygon> &polygons() const { return m_Polygons; }
+    int pointCount() const;
+    int projectedCount() const { return m_ProjectedCount; }
+
+private:
+    const Region &m_region;				// only read while tracing, in the constructor
+    vector<ContourMember> m_Members;
+    int m_Refinement;					// samples per step of the grid, see sampleRow
+    int m_SampleWidth, m_SampleHeight;
+    int m_PaddedWidth;					// samples per row, with the samples around the grid
+    int m_ProjectedCount;				// crossings projected onto the boundary of a member
+    vector<ContourPolygon> m_Polygons;
+    vector< pair<int, int> > m_Segments;			// the sides crossed by each piece of the boundary
+    unordered_map<int, pair<int, int> > m_SideSegments;	// the two segments crossing each side
+    vector<RegionWord> m_SpreadPoints;	// the points of m_SpreadRow, each spread over its cell
+    int m_SpreadRow;
+    vector<RegionWord> m_SampleBits;
+
+    void traceCells();
+    void addSegment(int side_a, int side_b);
+    void linkSegments();
+    void paddedRow(int row, vector<RegionWord> &bits);
+    const RegionWord *sampleRow(int row);
+    static void setSample(vector<RegionWord> &bits, int column, bool flag);
+    bool sampleInside(const Region &region, int column, int row) const;
+    double sampleX(int column) const;
+    double sampleY(int row) const;
+    bool centreInside(int column, int row) const;
+    ContourPoint crossing(int side);
+    void projectCrossing(const int *columns, const int *rows, double &fraction);
+};
+
+#endif // REGIONCONTOUR_H
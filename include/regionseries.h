@@ -0,0 +1,64 @@
+/*!	Author(s):	Emerick Bosch
+    Build:		0.3
+    Date:		July 2014
+
+    regionseries.h
+    ---------------
+
+    Description
+    ============
+    Presents the points (or the problem points) of a Region to a Qwt curve
+    as a series of samples, without creating a point per sample: sample i is
+    found from the number of points before each word and the bits of its
+    word. The sub-points of the refined cells of the region follow the
+    points of the grid, found in the same way from the number of sub-points
+    before each cell. Samples are read without changing the series, so
+    curves may read them from several render threads.
+*/
+
+#ifndef REGIONSERIES_H
+#define REGIONSERIES_H
+
+///	Includes
+///	=========
+
+#include <vector>
+#include <qwt_series_data.h>
+
+#include "region.h"
+
+
+///	Enumerated Types
+///	=================
+
+enum RegionLayer
+{
+    RegionPoints	= 0,
+    RegionProblems,
+};
+
+
+///	Class
+///	======
+
+class RegionSeries : public QwtSeriesData<QPointF>
+{
+public:
+    RegionSeries(const Region &region, RegionLayer layer = RegionPoints);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    Region m_region;
+    RegionLayer m_layer;
+    std::vector<int> m_WordStart;	// samples before each word, and the total
+    std::vector<int> m_CellStart;	// samples before the sub-points of each cell, and the total
+
+    const RegionWord *row(int row) const;
+    QPointF subSample(int i) const;
+    RegionWord cellBits(int cell) const;
+};
+
+#endif // REGIONSERIES_H
@@ -13,6 +13,11 @@
     Provides methods to:
     - create the domain of the variable
     - check the validity of the variable name
+
+    The domain is not stored value by value: it is described by its spacing,
+    first value, step and size, and value(i) computes the i-th value on
+    demand. fill writes a run of values for the batch evaluation. Copies of a
+    variable therefore cost the same whatever the number of steps.
 */
 
 #ifndef VARIABLE_H
@@ -25,6 +30,7 @@
 #include<vector>
 #include<cassert>
 #include<math.h>
+#include"functionregistry.h"
 
 
 ///	Namespace
@@ -51,8 +57,13 @@ private:
     //	-----------------
 
     string m_name;
-    vector<double> m_domain;
     Spacing m_domainSpacing;
+    double m_domainStart;	// linear: first value
+    double m_domainStep;	// linear: spacing of the values; logarithmic: exponent range
+    double m_domainSteps;	// logarithmic: steps the exponent range is divided into
+    double m_domainBase;	// logarithmic: base of the values
+    int m_domainSkipped;	// logarithmic: negative roots skipped after the first value
+    int m_domainSize;		// number of values, 0 until the domain is created
     double m_min, m_max;
     int m_elements;
     int m_pos;
@@ -62,6 +73,8 @@ private:
 public:
     Variable ():
         m_name(""),
+        m_domainSpacing(Linear),
+        m_domainSize(0),
         m_elements(1),
         flag_populated(false),
         flag_initialized(false)
@@ -69,6 +82,7 @@ public:
 
     Variable(string name, double domain_start = 0, double domain_end = 0, int elements = 1):
         m_name(name),
+        m_domainSize(0),
         m_elements(elements)
     {
         setMinMax(domain_start, domain_end);
@@ -87,7 +101,7 @@ public:
         if (num1 > num2)	{ m_min = num2; m_max = num1; }
         else 				{ m_min = num1; m_max = num2; }
 
-        m_domain.clear();
+        m_domainSize = 0;
         flag_populated = false;
         flag_initialized = true;
     }
@@ -95,21 +109,62 @@ public:
     //	Getters
     //	--------
 
-    string name() { return m_name; }
+    const string &name() const { return m_name; }
+
+    int position() const { return m_pos; }
+
+    int elements() const { return m_elements; }
+
+    double min() const { return m_min; }
+
+    double max() const { return m_max; }
+
+    double currentValue() const { return value(m_pos); }
 
-    int position(){ return m_pos; }
+    Spacing domainSpacing() const { return m_domainSpacing; }
 
-    int elements() { return m_elements; }
+    int domainSize() const { return m_domainSize; }
 
-    double min() { return m_min; }
+    double value(int index) const
+    {
+        assert(index >= 0 && index < m_domainSize && "Variable: Index outside of the domain");
+
+        if (m_domainSpacing == Linear)
+            return m_domainStart + index*m_domainStep;
+
+        int i = (index == 0) ? 0 : index + m_domainSkipped;
+        return pow(m_domainBase, i*m_domainStep/m_domainSteps);
+    }
+
+    void fill(int start, int count, double *values) const
+    {
+        /*!	Writes values start to start + count - 1 of the domain. */
 
-    double max() { return m_max; }
+        assert(start >= 0 && start + count <= m_domainSize && "Variable: Values outside of the domain");
 
-    double currentValue() { return m_domain[m_pos]; }
+        if (m_domainSpacing == Linear){
+            for (int k = 0; k < count; k++) { values[k] = m_domainStart + (start + k)*m_domainStep; }
+            return;
+        }
+        for (int k = 0; k < count; k++) { values[k] = value(start + k); }
+    }
 
-    Spacing domainSpacing() { return m_domainSpacing; }
+    bool domainIsFinite() const
+    {
+        // linear values lie between the first and the last
+        if (m_domainSpacing == Linear && m_domainSize > 0){
+            double first = value(0);
+            double last = value(m_domainSize - 1);
+            return (first - first == 0) && (last - last == 0);
+        }
 
-    vector<double> domain() { return m_domain; }
+        for (int i = 0; i < m_domainSize; i++){
+            double v = value(i);
+            if (v - v != 0)
+                return false;
+        }
+        return true;
+    }
 
 
     //	Domain Creation
@@ -130,10 +185,9 @@ public:
         if (steps == 1) { spacing = 0; }
         else { spacing = (max - min)/static_cast<double>(steps - 1); }
 
-        m_domain.clear();
-        for (int i = 0; i < steps; i++){
-            m_domain.push_back( min + i*spacing );
-        }
+        m_domainStart = min;
+        m_domainStep = spacing;
+        m_domainSize = (steps > 0) ? static_cast<int>(ceil(steps)) : 0;
 
         resetPosition();
         flag_populated   = true;
@@ -157,18 +211,22 @@ public:
         double log_min = log(min)/log(base);
         double log_max = log(max)/log(base);
 
-        m_domain.clear();
+        m_domainBase = base;
+        m_domainStep = log_max - log_min;
+        m_domainSteps = steps;
+        m_domainSkipped = 0;
+        m_domainSize = 0;
         for (int i = 0; i < steps; i++){
-            double exponent = i*( log_max - log_min )/steps ;
+            double exponent = i*m_domainStep/steps;
 
-            // skip negative roots
-            if ((exponent < 0) && (exponent > -1)){ continue; }
+            // skip negative roots; the exponent is monotonic, so these follow the first value
+            if ((exponent < 0) && (exponent > -1)){ m_domainSkipped++; continue; }
 
-            m_domain.push_back( pow( base, exponent  ) );
+            m_domainSize++;
         }
 
         // account for skipped items
-        m_elements = m_domain.size();
+        m_elements = m_domainSize;
 
         resetPosition();
         flag_populated   = true;
@@ -189,7 +247,7 @@ public:
         else { m_pos++; }
     }
 
-    bool isEnd() { return m_pos == (m_elements - 1); }
+    bool isEnd() const { return m_pos == (m_elements - 1); }
 
     void resetPosition () { m_pos = 0; }
 
@@ -216,8 +274,8 @@ public:
             char c = *it;
             if (	// operators
                     (c == '+') || (c == '-') ||(c == '/') ||(c == '*') ||(c == '^') ||
-                    // parentheses
-                    (c == '(') || (c == ')') ||
+                    // parentheses and separators
+                    (c == '(') || (c == ')') || (c == ',') ||
                     // whitespace
                     (c == ' ')  || (c == '\t') || (c == '\n')  || (c == '\r') ||
                     (c == '\v') || (c == '\b') || (c == '\f')
@@ -228,18 +286,7 @@ public:
         return true; // all checks passed
     }
 
-    static bool isFunction(string sName)
-    {
-         return (sName == "sin") 		|| (sName == "cos") 	|| (sName == "tan") 	||
-                (sName == "sec") 		|| (sName == "csc") 	|| (sName == "cot") 	||
-                (sName == "sinh")		|| (sName == "cosh")	|| (sName == "tanh")	||
-                (sName == "sech") 		|| (sName == "csch") 	|| (sName == "coth") 	||
-                (sName == "arcsin") 	|| (sName == "arccos") 	|| (sName == "arctan") 	||
-                (sName == "arcsec") 	|| (sName == "arccsc") 	|| (sName == "arccot") 	||
-                (sName == "arcsinh")	|| (sName == "arccosh")	|| (sName == "arctanh") ||
-                (sName == "arcsech") 	|| (sName == "arccsch") || (sName == "arccoth") ||
-                (sName == "exp") 		|| (sName == "ln") 		|| (sName == "log");
-    }
+    static bool isFunction(string sName) { return FunctionRegistry::isFunction(sName); }
 
     static bool isStandardValue(string sName)
     {
@@ -19,9 +19,22 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 TARGET = plotus
 TEMPLATE = app
 
+# batch evaluation loops are written to be auto-vectorized
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+# lets the square roots in the fast math kernels vectorize; nothing checks errno
+QMAKE_CXXFLAGS += -fno-math-errno
+
+# no -march here: the math kernels carry their own AVX2/AVX-512 versions and
+# pick one at runtime, so one binary runs on any x86-64 CPU
+
 SOURCES += src/main.cpp \
     src/bluejson.cpp \
     src/expression.cpp \
+    src/mathkernels.cpp \
+    src/jitcompiler.cpp \
+    src/functionregistry.cpp \
     src/inequalityinput.cpp \
     src/inequalityloader.cpp \
     src/variableinput.cpp \
@@ -29,12 +42,21 @@ SOURCES += src/main.cpp \
     src/plotworker.cpp \
     src/exportdialog.cpp \
     src/inequality.cpp \
+    src/region.cpp \
+    src/regionseries.cpp \
+    src/regioncontour.cpp \
     src/plotus.cpp
 
 HEADERS  += include/variableinput.h \
     include/bluejson.h \
     include/expression.h \
+    include/mathkernels.h \
+    include/jitcompiler.h \
+    include/functionregistry.h \
     include/inequality.h \
+    include/region.h \
+    include/regionseries.h \
+    include/regioncontour.h \
     include/inequalityinput.h \
     include/inequalityloader.h \
     include/variable.h \
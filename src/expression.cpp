@@ -2,6 +2,8 @@
 /// =========
 
     #include"include/expression.h"
+    #include"include/jitcompiler.h"
+    #include<fenv.h>
 
 
 ///	Public Functions
@@ -30,17 +32,22 @@ void Expression::setExpression(string expression)
     // validate
     m_Expression_Problems = checkExpressionArray(m_OriginalExpression);
 
-    // assign expression to working expression
-    resetExpression();
+    // compile to bytecode
+    compileExpression();
 }
 
-void Expression::addVariable(Variable variable)
+void Expression::addVariable(const Variable &variable)
 {
     assert(variableNameIsValid(variable));
+    m_VariableSlots[variable.name()] = static_cast<int>(m_Variables.size());
     m_Variables.push_back(variable);
 }
 
-void Expression::clearVariables(){ m_Variables.clear(); }
+void Expression::clearVariables()
+{
+    m_Variables.clear();
+    m_VariableSlots.clear();
+}
 
 void Expression::setCancelPointer(bool *ptr) { flag_Cancel = ptr; }
 
@@ -48,13 +55,13 @@ void Expression::setCancelPointer(bool *ptr) { flag_Cancel = ptr; }
 //	Getters
 //	-------
 
-int Expression::getNumTerms(){ return static_cast<int> (m_WorkingExpression.size()); }
+int Expression::getNumTerms(){ return static_cast<int> (m_OriginalExpression.size()); }
 
 string Expression::getExpression(){ return getStringArray(m_OriginalExpression); }
 
 string Expression::getTerm(int term_pos)
 {
-    assert(!(term_pos < 0 || term_pos >= static_cast<int>(m_WorkingExpression.size())) && "getTerm: Out of Bounds");
+    assert(!(term_pos < 0 || term_pos >= static_cast<int>(m_OriginalExpression.size())) && "getTerm: Out of Bounds");
     return m_OriginalExpression[term_pos];
 }
 
@@ -62,73 +69,289 @@ string Expression::getErrors(){ return m_ErrorMessage; }
 
 bool Expression::isValid(){ return flag_Valid; }
 
-vector<int> Expression::getProblemElements_Expression(){ return m_Expression_Problems; }
+const vector<int> &Expression::getProblemElements_Expression(){ return m_Expression_Problems; }
 
-vector<int> Expression::getProblemElements_Result(){ return m_Results_Problems; }
+const vector<int> &Expression::getProblemElements_Result(){ return m_Results_Problems; }
 
-bool Expression::isXBeforeY(Variable x_variable, Variable y_variable)
+const vector<int> &Expression::getResultStrides(){ return m_ResultStrides; }
+
+//	Evaluation
+//	-----------
+
+void Expression::subVariableValues()
 {
-    /*! Returns true if variable X is listed before variable Y in m_Variables*/
+    /*!	Binds the variables of the compiled expression to their slots in
+        m_Variables. Names are only looked up here, never during evaluation.*/
 
-    for (int i = 0; i < static_cast<int>(m_Variables.size()); i++){
-        if (m_Variables[i].name() == x_variable.name())	{ return true; }
-        else if (m_Variables[i].name() == y_variable.name()) { return false; }
+    for (int j = 0; j < static_cast<int>(m_SourceProgram.size()); j++){	// for all instructions
+        Instruction &instruction = m_SourceProgram[j];
+        if (instruction.code != OpVariable)
+            continue;
+
+        const string &text = m_OriginalExpression[instruction.term];
+        string term = (text[0] == '-') ? text.substr(1) : text;
+        instruction.slot = variableSlot(term);
+
+        if (instruction.slot == UninitializedCounter){
+            m_Expression_Problems.push_back(instruction.term);
+            flag_Valid = false;
+            m_ErrorMessage += "Error | Uninitialized variable: " + term + "\n";
+        }
     }
 
-    assert (false && "getXBeforeY: Neither X nor Y variables were found. Make sure they are added.");
+    if (!flag_Valid){
+        throw InputErrorUninitializedVariable; // only throw exception after all terms checked
+    }
+
+    // fold the variables which have a single value (e.g. slider constants)
+    simplifyProgram();
 
-    return false; 	// will never get here, used just for synta
+    // native code depends on the slots, so it is looked up once they are bound
+    int inner_slot = static_cast<int>(m_Variables.size()) - 1;
+    m_JitProgram = JitCompiler::compile(getJitKey(), m_Program, inner_slot);
 }
 
-//	Evaluation
-//	-----------
+const vector<double> &Expression::evaluateAll() { return evaluateProduct(false); }
 
-void Expression::subVariableValues()
+const vector<double> &Expression::evaluateDependent() { return evaluateProduct(true); }
+
+const vector<double> &Expression::evaluateProduct(bool flag_dependent_only)
 {
-    m_TermCount = m_WorkingExpression.size();
+    /*!	Evaluates all combinations of the values of the variables, nested in
+        the order in which they were added. If flag_dependent_only is set,
+        variables the bound program does not reference are given a single
+        value, so an expression of only x over an (x, y) grid is evaluated
+        once per x. In the results, the values of variable i are
+        getResultStrides()[i] apart; the stride is 0 for variables which were
+        not evaluated. The results are held until the next evaluation.*/
 
-    for (int j = 0; j < m_TermCount; j++){	// for all terms
-        string term = m_WorkingExpression[j];
-        bool flag_initialized = false;
+    if (!flag_Valid)
+        throw InputErrorInvalidExpression;
 
-        for (int i = 0; i < static_cast<int>(m_Variables.size()); i++){ // for all variables
-            if (m_Variables[i].name() == term){
-                ostringstream buffer;
+    subVariableValues();
+    resetEvaluation();
 
-                buffer << m_Variables[i].currentValue();
-                m_WorkingExpression[j] = buffer.str();
+    int variable_count = static_cast<int>(m_Variables.size());
+    vector<bool> flag_referenced(variable_count, !flag_dependent_only);
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        if (m_Program[i].code == OpVariable)
+            flag_referenced[m_Program[i].slot] = true;
+    }
 
-                flag_initialized = true;
-            } else if (("-" + m_Variables[i].name()) == term){
-                ostringstream buffer;
+    m_Extents.assign(variable_count, 1);
+    m_ResultStrides.assign(variable_count, 0);
+    int stride = 1;
+    for (int i = variable_count - 1; i >= 0; i--){
+        if (!flag_referenced[i])
+            continue;
+        m_Extents[i] = m_Variables[i].elements();
+        m_ResultStrides[i] = stride;
+        stride *= m_Extents[i];
+    }
 
-                buffer << -1 * m_Variables[i].currentValue();
-                m_WorkingExpression[j] = buffer.str();
+    // outer variables are broadcast from their current value,
+    // the values of the innermost variable are computed from its domain
+    m_SlotValues.assign(variable_count, 0);
+    m_Spans.clear();
+    for (int i = 0; i < variable_count; i++){
+        BatchSpan span = { &m_SlotValues[i], 0, 0 };
+        m_Spans.push_back(span);
+    }
+    m_InnerCount = 1;
+    if (variable_count > 0){
+        const Variable &inner_variable = m_Variables[variable_count-1];
+        m_InnerCount = min(inner_variable.domainSize(), m_Extents.back());
+        m_Spans.back().values = 0;
+        m_Spans.back().variable = &inner_variable;
+    }
 
-                flag_initialized = true;
-            }
-        }
+    flag_FiniteInputs = inputsAreFinite();
+
+    // instructions which do not depend on the innermost variable
+    // are evaluated in the loops of the outer variables
+    flag_Hoisted = variable_count > 1;
+    if (flag_Hoisted){
+        computeLevels();
+        m_BatchRegisters.resize(m_Program.size() * BATCH_SIZE);
+        m_HoistedErrors.assign(m_Program.size(), 0);
+        m_LevelNonFinite.assign(variable_count, false);
+        evaluateLevel(0);
+    }
 
-        if (!flag_initialized && Variable::nameIsLegal(term)){
-            m_Expression_Problems.push_back(j);
-            flag_Valid = false;
-            m_ErrorMessage += "Error | Uninitialized variable: " + term + "\n";
+    evaluateGrid();
+    flag_Hoisted = false;
+    return m_Results;
+}
+
+void Expression::prepareBatches()
+{
+    /*!	Binds the variables and resets the evaluation, for evaluating points
+        chosen by the caller with evaluateBatch rather than the whole grid.*/
+
+    if (!flag_Valid)
+        throw InputErrorInvalidExpression;
+
+    subVariableValues();
+    resetEvaluation();
+    flag_FiniteInputs = inputsAreFinite();
+}
+
+double Expression::estimateCost()
+{
+    /*!	Estimates the time to evaluate one point, in additions, from the
+        instructions of the bound program: division and square roots cost a
+        few additions, powers and functions (see FunctionRegistry) many.*/
+
+    subVariableValues();
+
+    double cost = 0;
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        const Instruction &instruction = m_Program[i];
+        switch (instruction.code){
+        case OpConstant:
+        case OpVariable:
+            break;
+        case OpDivide:
+        case OpSquareRoot:
+            cost += 4;
+            break;
+        case OpPower:
+            cost += 20;
+            break;
+        case OpFunction:
+            cost += FunctionRegistry::entry(instruction.function).cost;
+            break;
+        default:
+            cost += 1;
+            break;
         }
     }
+    return cost;
+}
 
-    if (!flag_Valid){
-        throw InputErrorUninitializedVariable; // only throw exception after all terms checked
+Interval Expression::evaluateInterval(const vector<Interval> &variables)
+{
+    /*!	Bounds the values of the bound program (see prepareBatches) where
+        variable slot i lies in variables[i]. The bounds also hold for the
+        rounded values of evaluateBatch: rounding to nearest is monotonic, and
+        the functions are widened (see FunctionRegistry::bound). The result
+        is flagged if a point in the bounds may have a math error.*/
+
+    assert(variables.size() == m_Variables.size() && "evaluateInterval: One interval is needed per variable.");
+
+    if (m_Program.empty())
+        return makeInterval(0, 0);
+
+    m_IntervalRegisters.resize(m_Program.size());
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        Interval bounds = boundInstruction(m_Program[i], m_IntervalRegisters.data(), variables);
+
+        // infinite bounds may hide NaN points, e.g. from inf - inf
+        if (bounds.lower - bounds.lower != 0 || bounds.upper - bounds.upper != 0)
+            bounds = unboundedInterval();
+        m_IntervalRegisters[i] = bounds;
+    }
+    return m_IntervalRegisters.back();
+}
+
+Interval Expression::evaluateSlope(const vector<Interval> &variables, int slot)
+{
+    /*!	Bounds the derivative of the bound program with respect to the
+        variable of slot, where variable slot i lies in variables[i]: the
+        dual counterpart of evaluateInterval, with intervals for both the
+        values and the derivatives. The result is flagged if a value in the
+        bounds may have a math error, or the derivative is not bounded (e.g.
+        sec, or a variable exponent), so a slope which is not flagged is
+        known for every point of the bounds.*/
+
+    assert(variables.size() == m_Variables.size() && "evaluateSlope: One interval is needed per variable.");
+
+    if (m_Program.empty())
+        return makeInterval(0, 0);
+
+    evaluateInterval(variables);
+    m_SlopeRegisters.resize(m_Program.size());
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        Interval bounds = boundSlope(i, slot);
+        if (bounds.lower - bounds.lower != 0 || bounds.upper - bounds.upper != 0)
+            bounds = unboundedInterval();
+        m_SlopeRegisters[i] = bounds;
+    }
+    return m_SlopeRegisters.back();
+}
+
+DualNumber Expression::evaluateDual(const vector<double> &variables, int x_slot, int y_slot, PointError &error)
+{
+    /*!	Evaluates the bound program (see prepareBatches) at the point where
+        variable slot i has the value variables[i], with its derivatives
+        with respect to the variables of x_slot and y_slot (either may be -1).
+        The values are those of evaluateBatch; error is set to the first
+        math error of the point, or 0, and the derivatives of a point with
+        an error are not meaningful.*/
+
+    assert(variables.size() == m_Variables.size() && "evaluateDual: One value is needed per variable.");
+
+    error = 0;
+    DualNumber result = { 0, 0, 0 };
+    if (m_Program.empty())
+        return result;
+
+    m_DualValues.resize(m_Program.size());
+    m_DualDx.resize(m_Program.size());
+    m_DualDy.resize(m_Program.size());
+
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        PointError instruction_error;
+        m_DualValues[i] = evaluateScalar(m_Program[i], m_DualValues.data(), variables.data(), instruction_error);
+        if (error == 0)
+            error = instruction_error;
+        differentiateInstruction(i, x_slot, y_slot);
     }
+
+    result.value = m_DualValues.back();
+    result.dx = m_DualDx.back();
+    result.dy = m_DualDy.back();
+    if (error == 0 && result.value - result.value != 0)
+        error = pointError(MathNaN);
+    return result;
 }
 
-vector<double> Expression::evaluateAll()
+void Expression::evaluateBatch(const vector<BatchSpan> &variables, int count, double *results, PointError *errors)
 {
+    /*!	Evaluates the compiled expression for count points at once.
+        Variable slot i reads its values from variables[i], or computes them
+        from the domain of variables[i].variable. Math errors do not
+        stop the evaluation: errors[k] is set to the first error of point k,
+        or 0, and the result of a point with an error is 0, as it was when
+        errors were thrown, so the point is still compared.*/
+
     if (!flag_Valid)
         throw InputErrorInvalidExpression;
 
-    resetEvaluation();
-    recEval();
-    return m_Results;
+    assert(variables.size() == m_Variables.size() && "evaluateBatch: One span is needed per variable.");
+
+    if (m_Program.empty()){
+        for (int k = 0; k < count; k++) { results[k] = 0; errors[k] = 0; }
+        return;
+    }
+
+    m_BatchRegisters.resize(m_Program.size() * BATCH_SIZE);
+
+    for (int start = 0; start < count; start += BATCH_SIZE){
+        if (*flag_Cancel) return;
+
+        int block = min(BATCH_SIZE, count - start);
+        evaluateBlock(variables, start, block, results + start, errors + start);
+    }
+
+    // MATH ERRORS HANDLED HERE
+    // only logs the problem points
+    for (int k = 0; k < count; k++){
+        if (errors[k] == 0)
+            continue;
+        handleMathException(mathError(errors[k]));
+        results[k] = 0;
+    }
 }
 
 
@@ -145,6 +368,8 @@ bool Expression::charIsAlpha(char c){ return (('A' <= c) && (c <= 'Z')) || (('a'
 
 bool Expression::charIsParenthesis(char c){ return (c == '(') || (c == ')'); }
 
+bool Expression::charIsSeparator(char c){ return (c == ','); }	// of function arguments
+
 bool Expression::charIsOperator(char c)
 {
     return 	(c == '+') || (c == '-') ||
@@ -181,7 +406,7 @@ vector<string> Expression::parseExpressionArray (string expression)
             flag_new_value = false;
             flag_preceding_operator = false;
         }
-        else if (charIsParenthesis(*it) || charIsOperator(*it)){
+        else if (charIsParenthesis(*it) || charIsOperator(*it) || charIsSeparator(*it)){
             // finish off value
             if (!flag_new_value){
                 terms.push_back(current_term);
@@ -197,8 +422,8 @@ vector<string> Expression::parseExpressionArray (string expression)
             if (*it == '-' && flag_preceding_operator) { flag_new_value = false; }
             else { terms.push_back(current_term); }
 
-            // if this is an operator, set the prev operator flag
-            if (charIsOperator(*it)) { flag_preceding_operator = true; }
+            // if this is an operator or separator, set the prev operator flag
+            if (charIsOperator(*it) || charIsSeparator(*it)) { flag_preceding_operator = true; }
             else { flag_preceding_operator = false; }
         } else if (charIsWhitespace(*it)){
             // do nothing, char is still recognized
@@ -376,15 +601,18 @@ vector<int> Expression::checkExpressionArray(vector<string> &expression)
     return error_terms;
 }
 
-bool Expression::variableNameIsUnique(Variable &variable)
+bool Expression::variableNameIsUnique(const Variable &variable){ return variableSlot(variable.name()) == UninitializedCounter; }
+
+int Expression::variableSlot(const string &name)
 {
-    for (vector<Variable>::iterator it = m_Variables.begin(); it != m_Variables.end(); it++){
-            if ((*it).name() == variable.name()){ return false; }
-    }
-    return true;
+    /*!	Returns the position of the named variable in m_Variables, or
+        UninitializedCounter if it has not been added.*/
+
+    unordered_map<string, int>::const_iterator it = m_VariableSlots.find(name);
+    return (it == m_VariableSlots.end()) ? UninitializedCounter : it->second;
 }
 
-bool Expression::variableNameIsValid(Variable & myVar)
+bool Expression::variableNameIsValid(const Variable &myVar)
 {
     string name = myVar.name();
     if (!Variable::nameIsLegal(name))
@@ -396,7 +624,7 @@ bool Expression::variableNameIsValid(Variable & myVar)
 
 bool Expression::charIsValid(char c)
 {
-    return charIsAlpha(c) || charIsDigit(c) || charIsOperator(c) || charIsParenthesis(c) || charIsWhitespace(c);
+    return charIsAlpha(c) || charIsDigit(c) || charIsOperator(c) || charIsParenthesis(c) || charIsSeparator(c) || charIsWhitespace(c);
 }
 
 bool Expression::termIsNumeric(string term){ return charIsDigit(term[0]); } // reason why variable names may not start with digit
@@ -407,639 +635,1122 @@ bool Expression::termIsStandardValue(string term){ return Variable::isStandardVa
 
 bool Expression::termIsFunction(string term){ return Variable::isFunction(term); }
 
+bool Expression::termIsOperator(string term){ return (term.size() == 1) && charIsOperator(term[0]); }
 
-//	Expression Reduction
-//	---------------------
-
-bool Expression::compressExpression(vector<string> &expression)
+bool Expression::termIsOperand(string term)
 {
-    m_TermCount = expression.size();
+    /*! Returns true if the term is a value by itself: a number or a variable.*/
 
-    for (int i = 0; i < m_TermCount; i++){
-        string term = expression[i];
+    string name = term;
+    if (name.size() > 1 && name[0] == '-')
+        name = name.substr(1);
 
-        // if compression character is found:
-        // shift everything after the compression character left by 1 and
-        // delete last term
-        if (COMPRESSION_CHAR == term[0]){
-            for (int j = i; j < m_TermCount-1; j++){
-                expression[j] = expression[j+1];
-            }
-            expression.pop_back();
-            return true;
-        }
-    }
-    return false; // if no whitespace is found
-}
+    if (name.empty() || termIsOperator(name))
+        return false;
 
-bool Expression::doParenthesis (vector<string> &expression)
-{
-    m_TermCount = expression.size();
-
-    int open_pos = UninitializedCounter;
-    int range = UninitializedCounter;
-    bool flag_empty_parenth;
-    string temp_term, term_before_operator, term_after_operator;
-
-    // find parentheses
-    for (int i = 0; i < m_TermCount; i++){
-        temp_term = expression[i];
-
-        // if opening parentheses found:
-        // start counting range,
-        // log term before parenth
-        if (charIsParenthesis(temp_term[0]) && temp_term[0] == '('){
-            open_pos = i;
-            if (i > 0)
-                term_before_operator = expression[i-1];
-        }
+    return 	termIsNumeric(name) ||
+            (termIsAlpha(name) && !termIsFunction(name) && !termIsStandardValue(name));
+}
 
-        // if closing parentheses found:
-        // check contents of parentheses
-        else if (charIsParenthesis(temp_term[0]) && temp_term[0] == ')'){
-
-            assert(open_pos != UninitializedCounter); // check for unopened bracket
-
-            // determine range
-            range = i - open_pos;
-
-            // log term after parenth
-            if (i+1 < m_TermCount)
-                term_after_operator = expression[i+1];
-
-            /// evaluate parenthesis
-            // if parentheses not empty,
-            // create new array from contents,
-            // perform maths on contents
-            // substitute result back into expression
-            if (range > 1){
-                flag_empty_parenth = false;
-                vector<string> sParenthesisArray;
-                for (int j = 0; j < range -1; j++){
-                    sParenthesisArray.push_back(expression[open_pos+1+j]);
-                }
-                doBasic(sParenthesisArray);
-                expression[open_pos] = sParenthesisArray[0];
-            }
 
-            // if parentheses empty,
-            // substitute parentheses with 0
-            else {
-                flag_empty_parenth = true;
-                expression[open_pos] = "0";
-            }
+//	Compilation
+//	------------
 
-            // insert compression characters
-            for (int j = open_pos+1; j < i+1; j++){
-                expression[j] = COMPRESSION_CHAR;
-            }
+void Expression::compileExpression()
+{
+    /*!	Compiles the original expression into register bytecode in a single
+        pass over its terms (see parseExpression), with each operation
+        emitting an instruction. The last instruction holds the result.*/
 
-            /// parenthesis multiplication
-            //	place multiplications before or after answer
-            bool flag_doneBefore = false;
-
-            //	multiply before parenth
-            if (!term_before_operator.empty()){
-                if (termIsNumeric(term_before_operator)){
-                    expression[open_pos+1] = expression[open_pos];
-                    expression[open_pos] = "*";
-                    flag_doneBefore = true;
-                }
-            }
+    m_Program.clear();
+    m_SourceProgram.clear();
+    m_JitProgram = 0;
 
-            //	multiply after parenth
-            //	if there was multiplication before parenth, positions change
-            if (!term_after_operator.empty()){
-                if (termIsNumeric(term_after_operator)){
-                    if (flag_empty_parenth){
-                        if (flag_doneBefore){ expression[open_pos+2] = COMPRESSION_CHAR; }
-                        else { expression[open_pos+1] = "*"; }
-                    } else {
-                        expression[open_pos+2] = "*";
-                    }
-                }
-            }
+    if (!flag_Valid)
+        return;
 
-            // compress expression
-            while(compressExpression(expression)){
-                //! loop will auto-terminate
+    try{
+        if (m_OriginalExpression.empty()){
+            emitConstant(0, UninitializedCounter);
+        } else {
+            int pos = 0;
+            int result = parseExpression(pos, PrecedenceNone);
+            if (result == UninitializedCounter)
+                throw InputErrorInvalidExpression;
+
+            // a well formed expression is a single value
+            if (pos < static_cast<int>(m_OriginalExpression.size())){
+                m_ProblemTerm = pos;
+                throw InputErrorInvalidExpression;
             }
-
-            // do special operations (sin, log, etc)
-            doSpecial(expression, open_pos, flag_empty_parenth);
-            return true;
         }
     }
+    catch(InputErrorCode e){
+        switch(e){
+        case InputErrorParenthesesEmpty:
+            m_ErrorMessage += "Error | Function needs value in parentheses.\n";
+            break;
+        case InputErrorParenthesesNotEmpty:
+            m_ErrorMessage += "Error | Parentheses after values must be empty.\n";
+            break;
+        case InputErrorArgumentCount:
+            m_ErrorMessage += "Error | Wrong number of values in function parentheses.\n";
+            break;
+        default:
+            m_ErrorMessage += "Error | Invalid expression.\n";
+            break;
+        }
+        m_Expression_Problems.push_back(m_ProblemTerm);
+        flag_Valid = false;
+        m_Program.clear();
+    }
 
-    // check for unclosed bracket
-    assert((open_pos == UninitializedCounter) && (range == UninitializedCounter));
-    return false;	// no parenthesis was found
+    // fold what is constant before any variables are bound
+    m_SourceProgram = m_Program;
+    simplifyProgram();
 }
 
-bool Expression::doPowers(vector<string> &expression)
+int Expression::emitInstruction(OpCode code, int lhs, int rhs, int term)
 {
-    m_TermCount = expression.size();
-
-    // powers must be done right to left (directional)
-    for (int i = m_TermCount-1; i > 0; i--){
-        string temp_term = expression[i];
-
-        // if operation found and it is the correct operation
-        if (charIsOperator(temp_term[0]) && temp_term[0] == '^'){
-            //do the math
-            string term_before_operator = expression[i-1];
-            string term_after_operator  = expression[i+1];
-            double value_before = atof(term_before_operator.c_str());
-            double value_after = atof(term_after_operator.c_str());
-
-            if ((value_before < 0) && (fmod(value_before, 1) != 0) && (fmod(value_after, 1) != 0))
-                throw MathComplex;
-            if ((value_before == 0) && (value_after == 0))
-                throw MathNaN;
-            if ((value_before == 0) && (value_after < 0))
-                throw MathPole;
-
-            double result =  pow(atof(term_before_operator.c_str()), atof(term_after_operator.c_str()));
-
-            // update expression:
-            // operator and second value filled with compression character
-            ostringstream buffer;
-            buffer << result;
-            expression[i-1] = buffer.str();
-            expression[i]   = COMPRESSION_CHAR;
-            expression[i+1] = COMPRESSION_CHAR;
-
-            // compress expression
-            while(compressExpression(expression)){
-                //! loop will auto-terminate
-            }
+    Instruction instruction;
+    instruction.code = code;
+    instruction.lhs = lhs;
+    instruction.rhs = rhs;
+    instruction.function = FunctionNone;
+    instruction.slot = UninitializedCounter;
+    instruction.term = term;
+    instruction.value = 0;
+
+    m_Program.push_back(instruction);
+    return static_cast<int>(m_Program.size()) - 1;
+}
 
-            return true; // if an operation was done:
-        }
-    }
-    return false;	// if no operation found
+int Expression::emitConstant(double value, int term)
+{
+    int reg = emitInstruction(OpConstant, UninitializedCounter, UninitializedCounter, term);
+    m_Program[reg].value = value;
+    return reg;
 }
 
-bool Expression::doDivision (vector<string>	&expression)
+int Expression::compileOperand(int term)
 {
-    m_TermCount = expression.size();
+    /*!	Emits the instructions for a number or variable term, returning the
+        register holding its value.*/
 
-    for (int i = 0; i < m_TermCount; i++){
-        string temp_term = expression[i];
+    string text = m_OriginalExpression[term];
 
-        // if operation found and it is the correct operation
-        if (charIsOperator(temp_term[0]) && temp_term[0] == '/'){
+    // numbers, including negative numbers
+    if (termIsNumeric(text) || (text[0] == '-' && charIsDigit(text[1])))
+        return emitConstant(atof(text.c_str()), term);
 
-           //do the math
-           string term_before_operator = expression[i-1];
-           string term_after_operator  = expression[i+1];
+    // variables, including negative variables
+    int reg = emitInstruction(OpVariable, UninitializedCounter, UninitializedCounter, term);
 
-           assert( !((term_after_operator.size() == 1) &&
-                   charIsOperator(term_after_operator[0])) );
+    if (text[0] == '-')
+        reg = emitInstruction(OpNegate, reg, UninitializedCounter, term);
 
-           if (atof(term_after_operator.c_str()) == 0)
-               throw MathDivideByZero;
+    return reg;
+}
 
-           double result = atof(term_before_operator.c_str()) / atof(term_after_operator.c_str());
 
-           // update expression - operator and second value filled with special character
-           ostringstream buffer;
-           buffer << result;
-           expression[i-1] = buffer.str();
-           expression[i]   = COMPRESSION_CHAR;
-           expression[i+1] = COMPRESSION_CHAR;
+//	Simplification
+//	---------------
 
-           // compress expression
-           while(compressExpression(expression)){
-               //! loop will auto-terminate
-           }
-           return true; // if an operation was done:
+void Expression::simplifyProgram()
+{
+    /*!	Rebuilds m_Program from m_SourceProgram in a single pass, folding
+        constant subtrees and variables with a single value (e.g. slider
+        constants), rewriting small powers and dropping identities.
+        Instructions whose folding would give a math error are kept, so that
+        the error is still reported at every point. Runs each time variables
+        are bound, so that changed constants are picked up cheaply.*/
+
+    m_Program.clear();
+
+    int size = static_cast<int>(m_SourceProgram.size());
+    if (size > 0){
+        vector<int> reg_of(size);
+        for (int i = 0; i < size; i++){
+            Instruction instruction = m_SourceProgram[i];
+            if (instruction.lhs >= 0) { instruction.lhs = reg_of[instruction.lhs]; }
+            if (instruction.rhs >= 0) { instruction.rhs = reg_of[instruction.rhs]; }
+            reg_of[i] = simplifyInstruction(instruction);
         }
+        eliminateDeadInstructions(reg_of[size-1]);
     }
-    return false; // if no operation found
 }
 
-bool Expression::doMultiplication (vector<string> &expression)
+int Expression::simplifyInstruction(Instruction instruction)
 {
-    m_TermCount = expression.size();
+    /*!	Emits the simplified form of an instruction whose operands are already
+        in m_Program, returning the register holding its value.*/
 
-    for (int i = 0; i < m_TermCount; i++){
-        string temp_term = expression[i];
+    int lhs = instruction.lhs;
+    int rhs = instruction.rhs;
+    int term = instruction.term;
 
-        // if operation found and it is the correct operation
-        if (charIsOperator(temp_term[0]) && temp_term[0] == '*'){
-
-            //do the math
-            string term_before_operator = expression[i-1];
-            string term_after_operator  = expression[i+1];
-            double result = atof(term_before_operator.c_str()) * atof(term_after_operator.c_str());
+    // variables with a single value
+    if (instruction.code == OpVariable){
+        if (instruction.slot >= 0 && m_Variables[instruction.slot].elements() == 1)
+            return emitConstant(m_Variables[instruction.slot].value(0), term);
+    }
 
-            // update expression:
-            // operator and second value filled with special character
-            ostringstream buffer;
-            buffer << result;
-            expression[i-1] = buffer.str();
-            expression[i]   = COMPRESSION_CHAR;
-            expression[i+1] = COMPRESSION_CHAR;
-
-            // compress expression
-            while(compressExpression(expression)){
-                //! loop will auto-terminate
-            }
+    // constant subtrees
+    bool flag_constant = (instruction.code != OpVariable) && (lhs < 0 || isConstant(lhs)) && (rhs < 0 || isConstant(rhs));
+    if (flag_constant && instruction.code != OpConstant){
+        double operands[2] = { lhs < 0 ? 0 : m_Program[lhs].value, rhs < 0 ? 0 : m_Program[rhs].value };
+        Instruction folded = instruction;
+        folded.lhs = 0;
+        folded.rhs = 1;
+        // not folded on an error, which is then reported when evaluating
+        PointError error;
+        double value = evaluateScalar(folded, operands, 0, error);
+        if (error == 0 && value - value == 0)
+            return emitConstant(value, term);
+    }
 
-            // if an operation was done:
-            return true;
+    // identities and small powers
+    switch(instruction.code){
+    case OpNegate:
+        if (m_Program[lhs].code == OpNegate) { return m_Program[lhs].lhs; }
+        break;
+    case OpAdd:
+        if (isConstant(rhs, 0)) { return lhs; }
+        if (isConstant(lhs, 0)) { return rhs; }
+        break;
+    case OpSubtract:
+        if (isConstant(rhs, 0)) { return lhs; }
+        if (isConstant(lhs, 0)) { return emitInstruction(OpNegate, rhs, UninitializedCounter, term); }
+        break;
+    case OpMultiply:
+        if (isConstant(rhs, 1)) { return lhs; }
+        if (isConstant(lhs, 1)) { return rhs; }
+        break;
+    case OpDivide:
+        if (isConstant(rhs, 1)) { return lhs; }
+        break;
+    case OpFunction:
+        // square roots have their own instruction, which is compiled natively
+        if (instruction.function == FunctionSqrt) { return emitInstruction(OpSquareRoot, lhs, UninitializedCounter, term); }
+        break;
+    case OpPower:
+        if (isConstant(rhs, 1)) { return lhs; }
+        if (isConstant(rhs, 2)) { return emitInstruction(OpMultiply, lhs, lhs, term); }
+        if (isConstant(rhs, 3)) {
+            int square = emitInstruction(OpMultiply, lhs, lhs, term);
+            return emitInstruction(OpMultiply, square, lhs, term);
         }
+        if (isConstant(rhs, 0.5)) { return emitInstruction(OpSquareRoot, lhs, UninitializedCounter, term); }
+        break;
+    default:
+        break;
     }
-    return false;	// if no operation found
+
+    m_Program.push_back(instruction);
+    return static_cast<int>(m_Program.size()) - 1;
 }
 
+bool Expression::isConstant(int reg) { return m_Program[reg].code == OpConstant; }
 
-bool Expression::doSubtraction (vector<string> &expression)
+bool Expression::isConstant(int reg, double value) { return isConstant(reg) && (m_Program[reg].value == value); }
+
+void Expression::eliminateDeadInstructions(int result)
 {
-    m_TermCount = expression.size();
-
-    for (int i = 0; i < m_TermCount; i++){
-        string temp_term = expression[i];
-
-        // if operation found and it is the correct operation
-        if (charIsOperator(temp_term[0]) && temp_term[0] == '-' && !charIsDigit(temp_term[1])){
-            double result;
-
-            // if '-' is at the beginning of expression , it signifies a negative number
-            if (i == 0){
-                // multiply the term after the minus by -1
-                string term_after_operator  = expression[i+1];
-                result = -1*atof(term_after_operator.c_str());
-
-                // update expression - operator and second value filled with special character
-                ostringstream buffer;
-                buffer << result;
-                expression[i] = buffer.str();
-                expression[i+1] = COMPRESSION_CHAR;
-            } else {
-                // do the math
-                string term_before_operator = expression[i-1];
-                string term_after_operator  = expression[i+1];
-                result = atof(term_before_operator.c_str()) - atof(term_after_operator.c_str());
-
-                // update expression:
-                // operator and second value filled with special character
-                ostringstream buffer;
-                buffer << result;
-                expression[i-1] = buffer.str();
-                expression[i]   = COMPRESSION_CHAR;
-                expression[i+1] = COMPRESSION_CHAR;
-            }
+    /*!	Removes the instructions the result does not depend on, leaving the
+        result in the last instruction.*/
+
+    vector<bool> flag_live(result + 1, false);
+    flag_live[result] = true;
+    for (int i = result; i >= 0; i--){
+        if (!flag_live[i])
+            continue;
+        if (m_Program[i].lhs >= 0) { flag_live[m_Program[i].lhs] = true; }
+        if (m_Program[i].rhs >= 0) { flag_live[m_Program[i].rhs] = true; }
+    }
 
-            // compress expression
-            while(compressExpression(expression)){
-                //! loop will auto-terminate
-            }
-            return true;	// if an operation was done:
-        }
+    vector<int> reg_of(result + 1, UninitializedCounter);
+    int count = 0;
+    for (int i = 0; i <= result; i++){
+        if (!flag_live[i])
+            continue;
+        Instruction instruction = m_Program[i];
+        if (instruction.lhs >= 0) { instruction.lhs = reg_of[instruction.lhs]; }
+        if (instruction.rhs >= 0) { instruction.rhs = reg_of[instruction.rhs]; }
+        m_Program[count] = instruction;
+        reg_of[i] = count++;
     }
-    return false;	// if no operation found
+    m_Program.resize(count);
 }
 
-bool Expression::doAddition (vector<string> &expression)
+
+//	Parsing
+//	--------
+
+int Expression::parseExpression(int &pos, int min_precedence)
 {
-    m_TermCount = expression.size();
-
-    for (int i = 0; i < m_TermCount; i++){
-        string temp_term = expression[i];
-
-        // if operation found and it is the correct operation
-        if (charIsOperator(temp_term[0]) && temp_term[0] == '+'){
-                //do the math
-                string term_before_operator = expression[i-1];
-                string term_after_operator  = expression[i+1];
-                double result = atof(term_before_operator.c_str()) + atof(term_after_operator.c_str());
-
-                // update expression:
-                // operator and second value filled with special character
-                ostringstream buffer;
-                buffer << result;
-                expression[i-1] = buffer.str();
-                expression[i]   = COMPRESSION_CHAR;
-                expression[i+1] = COMPRESSION_CHAR;
-
-                // compress expression
-                while(compressExpression(expression)){
-                    //! loop will auto-terminate
-                }
-
-                return true;	// if an operation was done
+    /*!	Compiles the terms from pos by precedence climbing, stopping before
+        the first operator which binds looser than min_precedence. Returns the
+        register of the result, or UninitializedCounter if the terms do not
+        start with an operand (m_ProblemTerm is then that term).
+
+        The precedences are those in which the expression has always been
+        reduced: powers (right to left), division, multiplication, subtraction
+        and addition, so "/" binds tighter than "*" and "-" tighter than "+".
+        A value directly before or after parentheses multiplies them. Every
+        term is visited once, so compilation is linear in the terms.*/
+
+    int size = static_cast<int>(m_OriginalExpression.size());
+    int lhs;
+
+    // '-' at the beginning of the expression or of parentheses negates the
+    // products, quotients and powers after it
+    if (pos < size && m_OriginalExpression[pos] == "-"){
+        int op_term = pos++;
+        int operand = parseExpression(pos, PrecedenceMultiplication);
+        if (operand == UninitializedCounter){
+            m_ProblemTerm = op_term;
+            throw InputErrorInvalidExpression;
         }
+        lhs = emitInstruction(OpNegate, operand, UninitializedCounter, op_term);
     }
-    return false;	// if no operation found
-}
+    else { lhs = parseOperand(pos); }
+
+    while (pos < size){
+        string term = m_OriginalExpression[pos];
+        int op_term = pos;
+        OpCode code;
+        int precedence;
+
+        if (termIsOperator(term)){
+            switch(term[0]){
+            case '+':	code = OpAdd;		precedence = PrecedenceAddition;		break;
+            case '-':	code = OpSubtract;	precedence = PrecedenceSubtraction;		break;
+            case '*':	code = OpMultiply;	precedence = PrecedenceMultiplication;	break;
+            case '/':	code = OpDivide;	precedence = PrecedenceDivision;		break;
+            default:	code = OpPower;		precedence = PrecedencePower;			break;
+            }
+        }
+        // multiplication with values, functions and standard values directly
+        // before or after parentheses
+        else if (term == "(" || (m_OriginalExpression[pos-1] == ")" && (termIsOperand(term) || termIsFunction(term) || termIsStandardValue(term)))){
+            code = OpMultiply;
+            precedence = PrecedenceMultiplication;
+            if (term != "(")
+                op_term = m_LastParenthesis;
+        }
+        else { break; }
 
-void Expression::doBasic(vector<string> &expression)
-{
-    //! loops will auto-terminate
-    while (doPowers(expression)) {}
-    while (doDivision(expression)) {}
-    while (doMultiplication(expression)) {}
-    while (doSubtraction(expression)) {}
-    while (doAddition(expression)) {}
+        if (precedence < min_precedence)
+            break;
+
+        if (lhs == UninitializedCounter){
+            m_ProblemTerm = op_term;
+            throw InputErrorInvalidExpression;
+        }
+
+        // powers are done right to left, everything else left to right
+        if (termIsOperator(term))
+            pos++;
+        int rhs = parseExpression(pos, (code == OpPower) ? precedence : precedence + 1);
+        if (rhs == UninitializedCounter){
+            m_ProblemTerm = op_term;
+            throw InputErrorInvalidExpression;
+        }
+        lhs = emitInstruction(code, lhs, rhs, op_term);
+    }
+    return lhs;
 }
 
-void Expression::doSpecial(vector<string> &expression, int eval_pos, bool flag_empty_parenth)
+int Expression::parseOperand(int &pos)
 {
-    // if the brackets were right at the beginning, nothing before them
-    // so no special function to be done
-    if (eval_pos < 1) { return; }
+    /*!	Compiles the operand at pos and moves pos past it: a number, a
+        variable, parentheses, or a function or standard value with its
+        parentheses. Returns UninitializedCounter if the term is not an
+        operand.*/
+
+    int size = static_cast<int>(m_OriginalExpression.size());
+    if (pos >= size){
+        m_ProblemTerm = size - 1;
+        return UninitializedCounter;
+    }
 
-    string term_before_operator = expression[eval_pos-1];
-    string eval_term = expression[eval_pos];
-    m_ProblemTerm = eval_pos;
-    double result;
+    int term = pos;
+    string text = m_OriginalExpression[term];
+    m_ProblemTerm = term;
 
-    //trig functions
-    if (term_before_operator == "sin"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = sin(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "cos"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = cos(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "tan"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = tan(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "sinh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = sinh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "cosh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = cosh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "tanh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = tanh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arcsin"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = asin(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arccos"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = acos(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arctan"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = atan(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arcsinh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = asinh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arccosh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = acosh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "arctanh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = atanh(atof(eval_term.c_str()));
-    }
-    //	negative
-    else if (term_before_operator == "-sin"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -sin(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "-cos"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -cos(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "-tan"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -tan(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "-sinh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -sinh(atof(eval_term.c_str()));
-    }
-    else if(term_before_operator == "-cosh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -cosh(atof(eval_term.c_str()));
+    // parentheses; empty parentheses are 0
+    if (text == "("){
+        int reg;
+        pos++;
+        if (pos < size && m_OriginalExpression[pos] == ")"){
+            reg = emitConstant(0, term);
+        } else {
+            reg = parseExpression(pos, PrecedenceNone);
+            if (reg == UninitializedCounter)
+                throw InputErrorInvalidExpression;
+            if (pos >= size || m_OriginalExpression[pos] != ")"){
+                m_ProblemTerm = (pos < size) ? pos : term;
+                throw InputErrorInvalidExpression;
+            }
+        }
+        pos++;
+        m_LastParenthesis = term;
+        return reg;
     }
-    else if(term_before_operator == "-tanh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -tanh(atof(eval_term.c_str()));
+
+    // numbers and variables
+    if (termIsOperand(text)){
+        pos++;
+        return compileOperand(term);
     }
-    else if(term_before_operator == "-arcsin"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -asin(atof(eval_term.c_str()));
+
+    // negative functions and values, e.g. -sin
+    string name = text;
+    bool flag_negative = (name.size() > 1) && (name[0] == '-');
+    if (flag_negative)
+        name = name.substr(1);
+
+    FunctionCode function = FunctionRegistry::lookup(name);
+    bool flag_special = termIsStandardValue(name) || (function != FunctionNone);
+    if (!flag_special || term + 1 >= size || m_OriginalExpression[term+1] != "("){
+        // not an operand; step over it unless it closes parentheses
+        if (text != ")")
+            pos++;
+        return UninitializedCounter;
     }
-    else if(term_before_operator == "-arccos"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -acos(atof(eval_term.c_str()));
+
+    pos++;
+    bool flag_empty_parenth = (pos + 1 < size) && (m_OriginalExpression[pos+1] == ")");
+    int reg;
+
+    // values
+    if (termIsStandardValue(name)){
+        parseOperand(pos);
+        m_ProblemTerm = term;
+        if (!flag_empty_parenth)
+            throw InputErrorParenthesesNotEmpty;
+        reg = emitConstant(PI, term);
     }
-    else if(term_before_operator == "-arctan"){
+
+    // functions
+    else {
+        m_ProblemTerm = term;
         if (flag_empty_parenth)
             throw InputErrorParenthesesEmpty;
-        result = -atan(atof(eval_term.c_str()));
+
+        reg = parseFunction(pos, function, term);
     }
-    else if(term_before_operator == "-arcsinh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -asinh(atof(eval_term.c_str()));
+
+    if (flag_negative)
+        reg = emitInstruction(OpNegate, reg, UninitializedCounter, term);
+    return reg;
+}
+
+int Expression::parseFunction(int &pos, FunctionCode function, int function_term)
+{
+    /*!	Compiles a call of a function, with pos at the parentheses holding
+        its arguments, which are separated by commas.*/
+
+    int size = static_cast<int>(m_OriginalExpression.size());
+    int open_term = pos++;
+    int arguments[2] = { UninitializedCounter, UninitializedCounter };	// lhs and rhs of the instruction
+    int argument_count = 0;
+    int comma_term = UninitializedCounter;
+
+    while (true){
+        int argument = parseExpression(pos, PrecedenceNone);
+        if (argument == UninitializedCounter){
+            if (comma_term != UninitializedCounter)
+                m_ProblemTerm = comma_term;
+            throw InputErrorInvalidExpression;
+        }
+        if (argument_count < 2)
+            arguments[argument_count] = argument;
+        argument_count++;
+
+        if (pos >= size || m_OriginalExpression[pos] != ",")
+            break;
+        comma_term = pos++;
     }
-    else if(term_before_operator == "-arccosh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -acosh(atof(eval_term.c_str()));
+
+    if (pos >= size || m_OriginalExpression[pos] != ")"){
+        m_ProblemTerm = (pos < size) ? pos : open_term;
+        throw InputErrorInvalidExpression;
     }
-    else if(term_before_operator == "-arctanh"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -atanh(atof(eval_term.c_str()));
+    pos++;
+    m_LastParenthesis = open_term;
+
+    if (argument_count != FunctionRegistry::entry(function).arity){
+        m_ProblemTerm = function_term;
+        throw InputErrorArgumentCount;
     }
 
-    //	exponential
-    else if(term_before_operator == "exp"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = exp(atof(eval_term.c_str()));
+    int reg = emitInstruction(OpFunction, arguments[0], arguments[1], function_term);
+    m_Program[reg].function = function;
+    return reg;
+}
+
+
+//	Grid Evaluation
+//	----------------
+
+void Expression::evaluateGrid()
+{
+    /*!	Iterates through all combinations of the outer variables with an
+        odometer, the last variable turning fastest; for each combination,
+        all values of the innermost variable are evaluated as one batch and
+        written to the next row of the results. Only the values and hoisted
+        instructions of the variables which turned are updated.*/
+
+    if (!flag_Valid)
+        throw InputErrorInvalidExpression;
+
+    int outer_count = max(static_cast<int>(m_Variables.size()) - 1, 0);
+    int row_count = 1;
+    for (int j = 0; j < outer_count; j++) { row_count *= m_Extents[j]; }
+
+    m_Results.resize(row_count * m_InnerCount);
+    m_ResultErrors.resize(m_InnerCount);
+
+    vector<int> position(outer_count, 0);
+    int turned = 0;		// outermost variable whose value changed
+    for (int row = 0; row < row_count; row++){
+        if (*flag_Cancel){
+            m_Results.resize(row * m_InnerCount);
+            return;
+        }
+
+        for (int j = turned; j < outer_count; j++){
+            m_SlotValues[j] = m_Variables[j].value(position[j]);
+            if (flag_Hoisted) { evaluateLevel(j + 1); }
+        }
+
+        int offset = row * m_InnerCount;
+        evaluateBatch(m_Spans, m_InnerCount, &m_Results[offset], m_ResultErrors.data());
+
+        for (int k = 0; k < m_InnerCount; k++){
+            if (m_ResultErrors[k] != 0)
+                m_Results_Problems.push_back(offset + k);
+        }
+
+        // next combination
+        for (turned = outer_count - 1; turned >= 0; turned--){
+            if (++position[turned] < m_Extents[turned])
+                break;
+            position[turned] = 0;
+        }
     }
-    else if(term_before_operator == "-exp"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        result = -exp(atof(eval_term.c_str()));
+}
+
+void Expression::computeLevels()
+{
+    /*!	Finds the loop level of each instruction: how many of the nested
+        variables, counting from the outermost, it depends on. Constants are
+        level 0, variable slot j is level j+1 and other instructions take the
+        highest level of their operands.*/
+
+    int size = static_cast<int>(m_Program.size());
+    m_Levels.assign(size, 0);
+    for (int i = 0; i < size; i++){
+        const Instruction &instruction = m_Program[i];
+        if (instruction.code == OpVariable)
+            m_Levels[i] = instruction.slot + 1;
+        if (instruction.lhs >= 0) { m_Levels[i] = max(m_Levels[i], m_Levels[instruction.lhs]); }
+        if (instruction.rhs >= 0) { m_Levels[i] = max(m_Levels[i], m_Levels[instruction.rhs]); }
     }
+}
 
-    // logarithmic functions
-    else if(term_before_operator == "log"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        double dEval = atof(eval_term.c_str());
-        if (dEval == 0)
-            throw MathPole;
-        result = log10(dEval);
+void Expression::evaluateLevel(int level)
+{
+    /*!	Evaluates the instructions of a level once, for the current values of
+        the outer variables, and broadcasts them over their batch registers.
+        The batches of the innermost variable then skip these instructions,
+        so e.g. f(x) in f(x)*g(y) is evaluated once per value of x instead of
+        once per point.*/
+
+    int width = min(BATCH_SIZE, m_InnerCount);
+    bool flag_nonfinite = (level > 0) && m_LevelNonFinite[level-1];
+
+    for (int i = 0; i < static_cast<int>(m_Program.size()); i++){
+        if (m_Levels[i] != level)
+            continue;
+
+        // errors are kept per instruction, as the blocks apply them in program order
+        m_HoistedErrors[i] = 0;
+        evaluateInstruction(i, m_Spans, 0, 1, &m_HoistedErrors[i], true);
+
+        double *row = &m_BatchRegisters[i*BATCH_SIZE];
+        for (int k = 1; k < width; k++) { row[k] = row[0]; }
+        flag_nonfinite = flag_nonfinite || (row[0] - row[0] != 0);
     }
-    else if(term_before_operator == "ln"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        double dEval = atof(eval_term.c_str());
-        if (dEval == 0)
-            throw MathPole;
-        result = log(dEval);
+
+    // the blocks only sample exception flags if the hoisted values are finite
+    m_LevelNonFinite[level] = flag_nonfinite;
+}
+
+bool Expression::isHoisted(int i)
+{
+    return flag_Hoisted && (m_Levels[i] < static_cast<int>(m_Variables.size()));
+}
+
+void Expression::evaluateBlock(const vector<BatchSpan> &variables, int start, int count, double *results, PointError *errors)
+{
+    /*!	Evaluates one block of at most BATCH_SIZE points, one instruction at a
+        time over the whole block, so that the arithmetic loops vectorize.
+        Math errors are classified branch-free alongside the values.
+
+        Where the exception flags are reliable (see canSampleExceptions), the
+        block is first evaluated without classifying the errors that always
+        raise FE_DIVBYZERO, FE_INVALID or FE_OVERFLOW. Most blocks raise
+        none and are done; the others are evaluated again, classifying.*/
+
+    int size = static_cast<int>(m_Program.size());
+    bool flag_sample = canSampleExceptions();
+    bool flag_done = false;
+    bool flag_native = false;
+
+    if (flag_sample)
+        feclearexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+
+    for (int k = 0; k < count; k++) { errors[k] = 0; }
+    if (m_JitProgram != 0){
+        // native code only reports that a division or square root was not finite
+        flag_native = evaluateBlockNative(variables, start, count, errors, !flag_sample);
+        flag_done = flag_native;
+    } else {
+        interpretBlock(variables, start, count, errors, !flag_sample);
+        flag_done = true;
     }
-    else if(term_before_operator == "-log"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        double dEval = atof(eval_term.c_str());
-        if (dEval == 0)
-            throw MathPole;
-        result = -log10(dEval);
+
+    if (flag_sample && fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW))
+        flag_done = false;
+
+    if (!flag_done){
+        flag_native = false;
+        for (int k = 0; k < count; k++) { errors[k] = 0; }
+        interpretBlock(variables, start, count, errors, true);
     }
-    else if(term_before_operator == "-ln"){
-        if (flag_empty_parenth)
-            throw InputErrorParenthesesEmpty;
-        double dEval = atof(eval_term.c_str());
-        if (dEval == 0)
-            throw MathPole;
-        result = -log(dEval);
+
+    const double *result = &m_BatchRegisters[(size-1)*BATCH_SIZE];
+    for (int k = 0; k < count; k++) { results[k] = result[k]; }
+
+    if (flag_native && JitCompiler::mode() == JitValidate)
+        validateBlockNative(variables, start, count, results, errors);
+}
+
+bool Expression::canSampleExceptions()
+{
+    /*!	True if every math error of a block raises an exception flag, unless
+        it is one evaluateInstruction always classifies. Non-finite values
+        then only come from operations which raised a flag themselves, so
+        e.g. inf/0 cannot hide a division by zero. This needs finite inputs,
+        and libm functions, as the fast kernels make NaN and infinity without
+        raising flags.*/
+
+    return flag_FiniteInputs &&
+           (MathKernels::accuracy() == AccuracyExact) &&
+           !(flag_Hoisted && m_LevelNonFinite.back());
+}
+
+bool Expression::inputsAreFinite()
+{
+    for (unsigned int i = 0; i < m_Program.size(); i++){
+        const Instruction &instruction = m_Program[i];
+        if (instruction.code == OpConstant && (instruction.value - instruction.value != 0))
+            return false;
+        if (instruction.code != OpVariable)
+            continue;
+
+        if (!m_Variables[instruction.slot].domainIsFinite())
+            return false;
     }
+    return true;
+}
 
-    // values
-    else if(term_before_operator == "pi"){
-        if (!flag_empty_parenth){
-            throw InputErrorParenthesesNotEmpty;
+void Expression::interpretBlock(const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify)
+{
+    for (int i = 0; i < static_cast<int>(m_Program.size()); i++){
+        if (isHoisted(i)){
+            applyHoistedError(i, errors, count);
+            continue;
         }
-        result = PI;
-    }
-    else if(term_before_operator == "-pi"){
-        if (!flag_empty_parenth)
-            throw InputErrorParenthesesNotEmpty;
-        result = -1*PI;
+        evaluateInstruction(i, variables, start, count, errors, flag_classify);
     }
+}
 
-    // no matching function
-    else { return; }
+void Expression::applyHoistedError(int i, PointError *errors, int count)
+{
+    PointError error = m_HoistedErrors[i];
+    if (error == 0)
+        return;
+    for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : error; }
+}
 
-    // return evaluated value:
-    // can only get here if 'break' out of switch
-    ostringstream buffer;
-    buffer << result;
+void Expression::evaluateInstruction(int i, const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify)
+{
+    /*!	Evaluates instruction i over a block of points. Points which did not
+        already have an error get the error of this instruction, if any; the
+        conditions are those of evaluateScalar. Unless flag_classify is set,
+        divisions, square roots and functions are not classified, as their
+        errors raise exception flags; powers always are, as 0^0 does not.*/
+
+    const Instruction &instruction = m_Program[i];
+    double * __restrict out = &m_BatchRegisters[i*BATCH_SIZE];
+    const double * __restrict lhs = &m_BatchRegisters[max(instruction.lhs, 0)*BATCH_SIZE];
+    const double * __restrict rhs = &m_BatchRegisters[max(instruction.rhs, 0)*BATCH_SIZE];
+
+    switch(instruction.code){
+    case OpConstant:
+        for (int k = 0; k < count; k++) { out[k] = instruction.value; }
+        break;
+    case OpVariable:
+        {
+            const BatchSpan &span = variables[instruction.slot];
+            const double *values = span.values + start*span.stride;
 
-    if ((buffer.str() == "nan") || (buffer.str() == "-nan"))
-        throw MathNaN;
+            if (span.variable != 0){
+                span.variable->fill(start, count, out);
+            } else if (span.stride == 1){
+                for (int k = 0; k < count; k++) { out[k] = values[k]; }
+            } else {
+                for (int k = 0; k < count; k++) { out[k] = values[k*span.stride]; }
+            }
+            break;
+        }
+    case OpNegate:
+        for (int k = 0; k < count; k++) { out[k] = -lhs[k]; }
+        break;
+    case OpAdd:
+        for (int k = 0; k < count; k++) { out[k] = lhs[k] + rhs[k]; }
+        break;
+    case OpSubtract:
+        for (int k = 0; k < count; k++) { out[k] = lhs[k] - rhs[k]; }
+        break;
+    case OpMultiply:
+        for (int k = 0; k < count; k++) { out[k] = lhs[k] * rhs[k]; }
+        break;
+    case OpDivide:
+        {
+            const PointError divide_by_zero = pointError(MathDivideByZero);
+            for (int k = 0; k < count; k++) { out[k] = lhs[k] / rhs[k]; }
+            if (!flag_classify)
+                break;
+            for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (rhs[k] == 0 ? divide_by_zero : 0); }
+            break;
+        }
+    case OpPower:
+        {
+            const PointError complex = pointError(MathComplex);
+            const PointError nan = pointError(MathNaN);
+            const PointError pole = pointError(MathPole);
+            for (int k = 0; k < count; k++) { out[k] = pow(lhs[k], rhs[k]); }
+            for (int k = 0; k < count; k++){
+                PointError error = (lhs[k] < 0 && !isInteger(rhs[k])) ? complex :
+                                   (lhs[k] == 0 && rhs[k] == 0) ? nan :
+                                   (lhs[k] == 0 && rhs[k] < 0) ? pole : 0;
+                errors[k] = errors[k] ? errors[k] : error;
+            }
+            break;
+        }
+    case OpSquareRoot:
+        {
+            const PointError complex = pointError(MathComplex);
+            for (int k = 0; k < count; k++) { out[k] = sqrt(lhs[k]); }
+            if (!flag_classify)
+                break;
+            for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (lhs[k] < 0 ? complex : 0); }
+            break;
+        }
+    case OpFunction:
+        FunctionRegistry::evaluate(instruction.function, lhs, rhs, out, flag_classify ? errors : 0, count);
+        break;
+    }
+}
 
-    expression[eval_pos-1] = buffer.str();
-    expression[eval_pos] = COMPRESSION_CHAR;
+bool Expression::evaluateBlockNative(const vector<BatchSpan> &variables, int start, int count, PointError *errors, bool flag_classify)
+{
+    /*!	Runs the native segments of the compiled program, interpreting the
+        instructions between them. Segments read variables as contiguous
+        values; other spans are gathered, and domains filled, into
+        m_JitInputs first. On a grid the segments which leave out the
+        hoisted instructions are run, and the errors of those are applied in
+        program order, as interpretBlock does. Returns false
+        if a segment saw a non-finite division or square root, which may be
+        a math error.*/
+
+    int slots = static_cast<int>(variables.size());
+    m_JitInputs.resize(slots * BATCH_SIZE);
+    m_JitVariables.resize(slots);
+
+    for (int j = 0; j < slots; j++){
+        const BatchSpan &span = variables[j];
+        const double *values = span.values + start*span.stride;
+
+        if (flag_Hoisted && j < slots - 1){
+            m_JitVariables[j] = 0;	// outer variables are only read by hoisted instructions
+        } else if (span.variable != 0){
+            double *row = &m_JitInputs[j*BATCH_SIZE];
+            span.variable->fill(start, count, row);
+            m_JitVariables[j] = row;
+        } else if (span.stride == 1){
+            m_JitVariables[j] = values;
+        } else {
+            double *row = &m_JitInputs[j*BATCH_SIZE];
+            for (int k = 0; k < count; k++) { row[k] = values[k*span.stride]; }
+            m_JitVariables[j] = row;
+        }
+    }
 
-    // compress expression
-    while(compressExpression(expression)){
-        //! loop will auto-terminate
+    const vector<JitStep> &steps = flag_Hoisted ? m_JitProgram->hoisted_steps : m_JitProgram->steps;
+    for (int s = 0; s < static_cast<int>(steps.size()); s++){
+        if (steps[s].segment != 0){
+            if (steps[s].segment(m_BatchRegisters.data(), m_JitVariables.data(), count) != 0)
+                return false;
+            if (!flag_Hoisted)
+                continue;
+            for (int i = steps[s].first; i < steps[s].last; i++){
+                if (isHoisted(i)) { applyHoistedError(i, errors, count); }
+            }
+        } else if (isHoisted(steps[s].first)){
+            applyHoistedError(steps[s].first, errors, count);
+        } else {
+            evaluateInstruction(steps[s].first, variables, start, count, errors, flag_classify);
+        }
     }
+
+    return true;
 }
 
+void Expression::validateBlockNative(const vector<BatchSpan> &variables, int start, int count, double *results, PointError *errors)
+{
+    /*!	Re-evaluates a block with the interpreter and compares it with the
+        results of the native code. On a mismatch the native code is dropped
+        for this expression and the interpreted results are kept.*/
+
+    PointError interpreted_errors[BATCH_SIZE] = {0};
+    interpretBlock(variables, start, count, interpreted_errors, true);
+
+    const double *result = &m_BatchRegisters[(m_Program.size()-1)*BATCH_SIZE];
+    bool flag_match = true;
+    for (int k = 0; k < count && flag_match; k++){
+        flag_match = (errors[k] == interpreted_errors[k]) &&
+                     ((results[k] == result[k]) || (results[k] != results[k] && result[k] != result[k]));
+        if (!flag_match){
+            cerr << "plotus: native code of '" << getExpression() << "' gave " << results[k]
+                 << " instead of " << result[k] << " at point " << start + k << endl;
+        }
+    }
 
-//	Recursive Evaluation
-//	---------------------
+    if (!flag_match){
+        m_JitProgram = 0;
+        for (int k = 0; k < count; k++) { results[k] = result[k]; errors[k] = interpreted_errors[k]; }
+    }
+}
 
-void Expression::recEval()
+double Expression::evaluateScalar(const Instruction &instruction, const double *reg, const double *slot_values, PointError &error)
 {
-    /*!	This function iterates through all combinations of variables
-        for each combination, an evaluation is performed.*/
+    /*!	Evaluates a single instruction, with its operands in reg. The math
+        error of the instruction, if any, is returned in error.*/
+
+    error = 0;
+
+    switch(instruction.code){
+    case OpConstant:
+        return instruction.value;
+    case OpVariable:
+        return slot_values[instruction.slot];
+    case OpNegate:
+        return -reg[instruction.lhs];
+    case OpAdd:
+        return reg[instruction.lhs] + reg[instruction.rhs];
+    case OpSubtract:
+        return reg[instruction.lhs] - reg[instruction.rhs];
+    case OpMultiply:
+        return reg[instruction.lhs] * reg[instruction.rhs];
+    case OpDivide:
+        if (reg[instruction.rhs] == 0)
+            error = pointError(MathDivideByZero);
+        return reg[instruction.lhs] / reg[instruction.rhs];
+    case OpPower:
+        {
+            double value_before = reg[instruction.lhs];
+            double value_after = reg[instruction.rhs];
 
-    if (!flag_Valid)
-        throw InputErrorInvalidExpression;
+            if ((value_before < 0) && !isInteger(value_after))
+                error = pointError(MathComplex);
+            else if ((value_before == 0) && (value_after == 0))
+                error = pointError(MathNaN);
+            else if ((value_before == 0) && (value_after < 0))
+                error = pointError(MathPole);
 
-    // for all values of the current variable (current variable is global)
-    for (int i = 0; i < m_Variables[m_CurrentVariable].elements(); i++){
-            int j = m_CurrentVariable;
-            if (*flag_Cancel) return;
-
-            // if this is the final nested variable;
-            // substitute current values and evaluate... (see else)
-            if (m_CurrentVariable == static_cast<int>(m_Variables.size()) - 1){
-                    // do math
-                    subVariableValues();
-                    double dResult;
-
-                    try{
-                        dResult = evaluateExpression();
-                    }
-                    catch(MathErrorCode e){
-                        // MATH ERRORS HANDLED HERE
-                        // does not stop the evaluation, only logs a problem point
-                        handleMathException(e);
-                        resetExpression();
-                        m_Results_Problems.push_back(m_Results.size());
-                        dResult = 0;
-                    }
-                    catch(InputErrorCode e){
-                        // INPUT ERRORS HANDLED HERE
-                        // stops the evaluation
-                        m_Expression_Problems.push_back(m_ProblemTerm);
-                        flag_Valid = false;
-                    }
-
-                    m_Results.push_back(dResult);
-            }
+            return pow(value_before, value_after);
+        }
+    case OpSquareRoot:
+        if (reg[instruction.lhs] < 0)
+            error = pointError(MathComplex);
+        return sqrt(reg[instruction.lhs]);
+    case OpFunction:
+        return FunctionRegistry::evaluate(instruction.function, reg[instruction.lhs], reg[max(instruction.rhs, 0)], error);
+    }
 
-            // ...otherwise move on to the next nested variable level
-            else {
-                    m_CurrentVariable++; 	// go to the next variable
-                    recEval(); 				// recurse through it
-                    m_CurrentVariable--;	// come back to this variable to carry on with it
-            }
+    assert(false && "evaluateScalar: Unknown instruction");
+    return 0;
+}
 
-            m_Variables[j].nextPosition();	// next variable
+void Expression::differentiateInstruction(int i, int x_slot, int y_slot)
+{
+    /*!	Writes the derivatives of instruction i from the values and
+        derivatives of its operands, by the chain rule; the dual counterpart
+        of evaluateScalar.*/
+
+    const Instruction &instruction = m_Program[i];
+    double coefficient_lhs = 0;		// derivative of the result with respect to each operand
+    double coefficient_rhs = 0;
+
+    switch(instruction.code){
+    case OpConstant:
+        m_DualDx[i] = 0;
+        m_DualDy[i] = 0;
+        return;
+    case OpVariable:
+        m_DualDx[i] = (instruction.slot == x_slot) ? 1 : 0;
+        m_DualDy[i] = (instruction.slot == y_slot) ? 1 : 0;
+        return;
+    case OpNegate:
+        coefficient_lhs = -1;
+        break;
+    case OpAdd:
+        coefficient_lhs = 1;
+        coefficient_rhs = 1;
+        break;
+    case OpSubtract:
+        coefficient_lhs = 1;
+        coefficient_rhs = -1;
+        break;
+    case OpMultiply:
+        coefficient_lhs = m_DualValues[instruction.rhs];
+        coefficient_rhs = m_DualValues[instruction.lhs];
+        break;
+    case OpDivide:
+        coefficient_lhs = 1/m_DualValues[instruction.rhs];
+        coefficient_rhs = -m_DualValues[i]/m_DualValues[instruction.rhs];
+        break;
+    case OpPower:
+        {
+            double base = m_DualValues[instruction.lhs];
+            double exponent = m_DualValues[instruction.rhs];
+            coefficient_lhs = (exponent == 0) ? 0 : exponent*pow(base, exponent - 1);
+            coefficient_rhs = m_DualValues[i]*log(base);
+            break;
+        }
+    case OpSquareRoot:
+        coefficient_lhs = 0.5/m_DualValues[i];
+        break;
+    case OpFunction:
+        FunctionRegistry::derivative(instruction.function, m_DualValues[instruction.lhs], m_DualValues[max(instruction.rhs, 0)],
+                m_DualValues[i], coefficient_lhs, coefficient_rhs);
+        break;
+    }
+
+    // operands which do not vary add nothing, even where their coefficient is infinite
+    m_DualDx[i] = 0;
+    m_DualDy[i] = 0;
+    int operands[2] = { instruction.lhs, instruction.rhs };
+    double coefficients[2] = { coefficient_lhs, coefficient_rhs };
+    for (int k = 0; k < 2 && operands[k] >= 0; k++){
+        if (m_DualDx[operands[k]] != 0) { m_DualDx[i] += coefficients[k]*m_DualDx[operands[k]]; }
+        if (m_DualDy[operands[k]] != 0) { m_DualDy[i] += coefficients[k]*m_DualDy[operands[k]]; }
     }
 }
 
-double Expression::evaluateExpression()
+Interval Expression::boundSlope(int i, int slot)
 {
-    /*!	Evaluates an expression. Variables must already added.*/
-
-    if (*flag_Cancel) return 0;
+    /*!	Bounds the derivative of instruction i from the bounds of the values
+        and derivatives of its operands, by the chain rule; the interval
+        counterpart of differentiateInstruction.*/
+
+    const Instruction &instruction = m_Program[i];
+    if (instruction.code == OpConstant)
+        return makeInterval(0, 0);
+    if (instruction.code == OpVariable)
+        return (instruction.slot == slot) ? makeInterval(1, 1) : makeInterval(0, 0);
+
+    const Interval &value = m_IntervalRegisters[i];
+    const Interval &a = m_IntervalRegisters[instruction.lhs];
+    const Interval &b = m_IntervalRegisters[max(instruction.rhs, 0)];
+    if (value.flag_error)
+        return unboundedInterval();
+
+    Interval coefficient_lhs = makeInterval(0, 0);		// derivative of the result with respect to each operand
+    Interval coefficient_rhs = makeInterval(0, 0);
+    switch(instruction.code){
+    case OpNegate:
+        coefficient_lhs = makeInterval(-1, -1);
+        break;
+    case OpAdd:
+        coefficient_lhs = makeInterval(1, 1);
+        coefficient_rhs = makeInterval(1, 1);
+        break;
+    case OpSubtract:
+        coefficient_lhs = makeInterval(1, 1);
+        coefficient_rhs = makeInterval(-1, -1);
+        break;
+    case OpMultiply:
+        coefficient_lhs = b;
+        coefficient_rhs = a;
+        break;
+    case OpDivide:
+        coefficient_lhs = boundArithmetic(OpDivide, makeInterval(1, 1), b);
+        coefficient_rhs = boundArithmetic(OpDivide, makeInterval(-value.upper, -value.lower), b);
+        break;
+    case OpPower:
+        {
+            // only a constant exponent: a^n has the derivative n*a^(n-1)
+            const Interval &exponent_slope = m_SlopeRegisters[instruction.rhs];
+            if (exponent_slope.lower != 0 || exponent_slope.upper != 0 || b.lower != b.upper)
+                return unboundedInterval();
+
+            double n = b.lower;
+            if (n == 1) { coefficient_lhs = makeInterval(1, 1); }
+            else if (n != 0) { coefficient_lhs = boundArithmetic(OpMultiply, makeInterval(n, n), boundPower(a, makeInterval(n - 1, n - 1))); }
+            break;
+        }
+    case OpSquareRoot:
+        coefficient_lhs = boundArithmetic(OpDivide, makeInterval(0.5, 0.5), value);
+        break;
+    case OpFunction:
+        FunctionRegistry::boundDerivative(instruction.function, a, b, value, coefficient_lhs, coefficient_rhs);
+        break;
+    default:
+        break;
+    }
 
-    if (!flag_Valid)
-        throw InputErrorInvalidExpression;
+    // operands which do not vary add nothing, even where their coefficient is unbounded
+    Interval slope = makeInterval(0, 0);
+    int operands[2] = { instruction.lhs, instruction.rhs };
+    const Interval *coefficients[2] = { &coefficient_lhs, &coefficient_rhs };
+    for (int k = 0; k < 2 && operands[k] >= 0; k++){
+        const Interval &operand_slope = m_SlopeRegisters[operands[k]];
+        if (!operand_slope.flag_error && operand_slope.lower == 0 && operand_slope.upper == 0)
+            continue;
+        slope = boundArithmetic(OpAdd, slope, boundArithmetic(OpMultiply, *coefficients[k], operand_slope));
+    }
+    return slope;
+}
 
-    // do parentheses; reduce the expression
-    while (doParenthesis(m_WorkingExpression)) {}
-    // evaluate reduced expression
-    doBasic(m_WorkingExpression);
+Interval Expression::boundInstruction(const Instruction &instruction, const Interval *reg, const vector<Interval> &variables)
+{
+    /*!	Bounds a single instruction, with the bounds of its operands in reg;
+        the interval counterpart of evaluateScalar.*/
+
+    if (instruction.code == OpConstant)
+        return makeInterval(instruction.value, instruction.value);
+    if (instruction.code == OpVariable)
+        return variables[instruction.slot];
+
+    const Interval &a = reg[instruction.lhs];
+    const Interval &b = reg[max(instruction.rhs, 0)];
+    bool flag_binary = (instruction.rhs >= 0);
+    if (a.flag_error || (flag_binary && b.flag_error))
+        return unboundedInterval();
+
+    switch(instruction.code){
+    case OpPower:
+        return boundPower(a, b);
+    case OpSquareRoot:
+        if (a.lower < 0)
+            return unboundedInterval();		// complex
+        return makeInterval(sqrt(a.lower), sqrt(a.upper));
+    case OpFunction:
+        return FunctionRegistry::bound(instruction.function, a, b);
+    default:
+        return boundArithmetic(instruction.code, a, b);
+    }
+}
 
-    string reduced_expression = m_WorkingExpression[0];
+Interval Expression::boundArithmetic(OpCode code, const Interval &a, const Interval &b)
+{
+    /*!	Bounds the arithmetic operations (negation uses only a).*/
+
+    if (a.flag_error || (code != OpNegate && b.flag_error))
+        return unboundedInterval();
+
+    switch(code){
+    case OpNegate:
+        return makeInterval(-a.upper, -a.lower);
+    case OpAdd:
+        return makeInterval(a.lower + b.lower, a.upper + b.upper);
+    case OpSubtract:
+        return makeInterval(a.lower - b.upper, a.upper - b.lower);
+    case OpMultiply:
+    case OpDivide:
+        {
+            if (code == OpDivide && b.lower <= 0 && b.upper >= 0)
+                return unboundedInterval();		// division by zero
+
+            double corners[4];
+            double left[2] = { a.lower, a.upper };
+            double right[2] = { b.lower, b.upper };
+            for (int k = 0; k < 4; k++){
+                double l = left[k/2];
+                double r = right[k%2];
+                corners[k] = (code == OpMultiply) ? l*r : l/r;
+            }
+            return makeInterval(*min_element(corners, corners + 4), *max_element(corners, corners + 4));
+        }
+    default:
+        break;
+    }
 
-    if (m_WorkingExpression.empty()) { reduced_expression = "0"; }
-    else { reduced_expression = m_WorkingExpression[0]; }
+    assert(false && "boundArithmetic: Unknown instruction");
+    return unboundedInterval();
+}
 
+Interval Expression::boundPower(const Interval &base, const Interval &exponent)
+{
+    /*!	Bounds base^exponent for an integer exponent, or a positive base.
+        Other powers may be complex and are not bounded. pow is not always
+        correctly rounded, so the bounds are widened a little.*/
+
+    Interval bounds;
+    const double relative = 1e-12;
+
+    if (exponent.lower == exponent.upper && isInteger(exponent.lower)){
+        double n = exponent.lower;
+        bool flag_contains_zero = (base.lower <= 0 && base.upper >= 0);
+        if (flag_contains_zero && n <= 0)
+            return unboundedInterval();		// 0^0 and poles
+
+        double a = pow(base.lower, n);
+        double b = pow(base.upper, n);
+        bool flag_even = fmod(n, 2) == 0;
+        bounds = makeInterval(min(a, b), max(a, b));
+        if (flag_even && flag_contains_zero)
+            bounds.lower = 0;
+    } else if (base.lower > 0){
+        // base^exponent = e^(exponent*ln(base)) is monotonic in both, so it is bounded by its corners
+        double corners[4] = { pow(base.lower, exponent.lower), pow(base.lower, exponent.upper),
+                              pow(base.upper, exponent.lower), pow(base.upper, exponent.upper) };
+        bounds = makeInterval(*min_element(corners, corners + 4), *max_element(corners, corners + 4));
+    } else {
+        return unboundedInterval();
+    }
 
-    double result = atof(reduced_expression.c_str());
-    resetExpression();
-    return result;
+    bounds.lower -= fabs(bounds.lower)*relative;
+    bounds.upper += fabs(bounds.upper)*relative;
+    return bounds;
 }
 
-void Expression::resetExpression(){ m_WorkingExpression = m_OriginalExpression; }
+bool Expression::isInteger(double value)
+{
+    /*!	Branch-free test for an integer value; false for infinities and NaN.
+        Adding and subtracting 2^52 rounds values below 2^52 to an integer,
+        larger doubles are all integers.*/
+
+    const double two_52 = 4503599627370496.0;
+    double magnitude = fabs(value);
+    return (magnitude < INFINITY) & ((magnitude >= two_52) | (((magnitude + two_52) - two_52) == magnitude));
+}
 
 
 //	Output
@@ -1056,6 +1767,31 @@ string Expression::getStringArray(vector<string> string_array)
     return result;
 }
 
+string Expression::getJitKey()
+{
+    /*!	Identifies the compiled program: the terms of the expression separated
+        by spaces, which removes any formatting, followed by the number of
+        variables, which decides what is hoisted, the variable slots and the
+        values of those which were folded into constants.*/
+
+    stringstream key;
+    key.precision(17);
+    for (unsigned int i = 0; i < m_OriginalExpression.size(); i++){
+        key << m_OriginalExpression[i] << ' ';
+    }
+    key << '|' << m_Variables.size() << '|';
+    for (unsigned int i = 0; i < m_SourceProgram.size(); i++){
+        const Instruction &instruction = m_SourceProgram[i];
+        if (instruction.code != OpVariable)
+            continue;
+
+        key << ' ' << instruction.slot;
+        if (m_Variables[instruction.slot].elements() == 1)
+            key << '=' << m_Variables[instruction.slot].value(0);
+    }
+    return key.str();
+}
+
 
 // 	Exception Handling and Validation
 //	----------------------------------
@@ -1092,8 +1828,10 @@ void Expression::handleMathException(MathErrorCode e)
 
 void Expression::resetEvaluation()
 {
-    m_CurrentVariable = 0;
     m_Results.clear();
+    m_Results_Problems.clear();
+    flag_Hoisted = false;
+    flag_FiniteInputs = false;
     flag_Nan = false;
     flag_Pole = false;
     flag_DivByZero = false;
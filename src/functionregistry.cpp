@@ -0,0 +1,480 @@
+#include"include/functionregistry.h"
+#include"include/mathkernels.h"
+#include<math.h>
+#include<cassert>
+
+
+//	Implementations
+//	----------------
+
+namespace {
+
+const int s_block = 256;	// values inverted at a time by the inverse reciprocal functions
+
+template<double (*function)(double)>
+double scalarOf(double lhs, double) { return function(lhs); }
+
+template<double (*function)(double)>
+double scalarReciprocal(double lhs, double) { return 1/function(lhs); }
+
+template<double (*function)(double)>
+double scalarOfReciprocal(double lhs, double) { return function(1/lhs); }
+
+template<KernelLoop kernel>
+void batchOf(const double *lhs, const double *, double *results, int count) { kernel(lhs, results, count); }
+
+template<KernelLoop kernel>
+void batchReciprocal(const double *lhs, const double *, double *results, int count)
+{
+    kernel(lhs, results, count);
+    for (int k = 0; k < count; k++) { results[k] = 1/results[k]; }
+}
+
+template<KernelLoop kernel>
+void batchOfReciprocal(const double *lhs, const double *, double *results, int count)
+{
+    // initialized, as the compiler cannot see that kernel only reads the block
+    double inverse[s_block] = {};
+    for (int start = 0; start < count; start += s_block){
+        int block = (count - start < s_block) ? count - start : s_block;
+        for (int k = 0; k < block; k++) { inverse[k] = 1/lhs[start + k]; }
+        kernel(inverse, results + start, block);
+    }
+}
+
+double scalarMin(double lhs, double rhs) { return (rhs < lhs) ? rhs : lhs; }
+
+double scalarMax(double lhs, double rhs) { return (lhs < rhs) ? rhs : lhs; }
+
+void batchMin(const double *lhs, const double *rhs, double *results, int count)
+{
+    for (int k = 0; k < count; k++) { results[k] = (rhs[k] < lhs[k]) ? rhs[k] : lhs[k]; }
+}
+
+void batchMax(const double *lhs, const double *rhs, double *results, int count)
+{
+    for (int k = 0; k < count; k++) { results[k] = (lhs[k] < rhs[k]) ? rhs[k] : lhs[k]; }
+}
+
+void batchAbs(const double *lhs, const double *, double *results, int count)
+{
+    for (int k = 0; k < count; k++) { results[k] = fabs(lhs[k]); }
+}
+
+void batchSquareRoot(const double *lhs, const double *, double *results, int count)
+{
+    for (int k = 0; k < count; k++) { results[k] = sqrt(lhs[k]); }
+}
+
+
+//	Domain Checks
+//	--------------
+//	Points which already have an error keep it.
+
+void poleAtZero(const double *lhs, const double *, const double *, PointError *errors, int count)
+{
+    const PointError pole = pointError(MathPole);
+    for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (lhs[k] == 0 ? pole : 0); }
+}
+
+void poleAtInfinity(const double *, const double *, const double *results, PointError *errors, int count)
+{
+    // reciprocals of periodic functions: the denominator is 0
+    const PointError pole = pointError(MathPole);
+    for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (fabs(results[k]) == INFINITY ? pole : 0); }
+}
+
+void complexBelowZero(const double *lhs, const double *, const double *, PointError *errors, int count)
+{
+    const PointError complex = pointError(MathComplex);
+    for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (lhs[k] < 0 ? complex : 0); }
+}
+
+void flagNaNs(const double *results, PointError *errors, int count)
+{
+    const PointError nan = pointError(MathNaN);
+    for (int k = 0; k < count; k++) { errors[k] = errors[k] ? errors[k] : (results[k] != results[k] ? nan : 0); }
+}
+
+
+
+//	Interval Bounds
+//	----------------
+//	The kernels are not correctly rounded and may differ from the C math
+//	library by a few units in the last place, so bounds computed with the
+//	library are widened.
+
+const double s_pi = 3.141592653589793238462643383279502884;
+
+Interval widened(Interval interval)
+{
+    const double relative = 1e-12;
+    const double absolute = 1e-14;
+    interval.lower -= fabs(interval.lower)*relative + absolute;
+    interval.upper += fabs(interval.upper)*relative + absolute;
+    return interval;
+}
+
+//	An interval which is already flagged stays unbounded.
+
+template<double (*function)(double)>
+Interval increasing(const Interval &x)
+{
+    if (x.flag_error)
+        return x;
+    return widened(makeInterval(function(x.lower), function(x.upper)));
+}
+
+template<double (*function)(double)>
+Interval decreasing(const Interval &x)
+{
+    if (x.flag_error)
+        return x;
+    return widened(makeInterval(function(x.upper), function(x.lower)));
+}
+
+bool containsPeriodic(const Interval &x, double point, double period)
+{
+    // x contains point + k*period for some integer k
+    double k = ceil((x.lower - point)/period);
+    return point + k*period <= x.upper;
+}
+
+Interval periodicBounds(const Interval &x, double (*function)(double), double maximum, double minimum)
+{
+    // sin and cos, with their maximum and minimum at the given phases; not defined at infinity
+    if (x.flag_error || fabs(x.lower) == INFINITY || fabs(x.upper) == INFINITY)
+        return unboundedInterval();
+    if (x.upper - x.lower >= 2*s_pi)
+        return makeInterval(-1, 1);
+
+    double a = function(x.lower);
+    double b = function(x.upper);
+    Interval bounds = widened(makeInterval(a < b ? a : b, a < b ? b : a));
+    if (containsPeriodic(x, maximum, 2*s_pi)) { bounds.upper = 1; }
+    if (containsPeriodic(x, minimum, 2*s_pi)) { bounds.lower = -1; }
+    return bounds;
+}
+
+Interval sinBounds(const Interval &x) { return periodicBounds(x, sin, s_pi/2, -s_pi/2); }
+
+Interval cosBounds(const Interval &x) { return periodicBounds(x, cos, 0, s_pi); }
+
+Interval tanBounds(const Interval &x)
+{
+    // increasing between the poles at pi/2 + k*pi
+    if (x.flag_error || x.upper - x.lower >= s_pi || containsPeriodic(x, s_pi/2, s_pi))
+        return unboundedInterval();
+    return increasing<tan>(x);
+}
+
+Interval evenBounds(const Interval &x, double (*function)(double))
+{
+    // cosh and abs: decreasing below 0, increasing above
+    if (x.flag_error)
+        return x;
+
+    double a = function(x.lower);
+    double b = function(x.upper);
+    double upper = (a < b) ? b : a;
+    if (x.lower <= 0 && x.upper >= 0)
+        return widened(makeInterval(function(0), upper));
+    return widened(makeInterval(a < b ? a : b, upper));
+}
+
+Interval reciprocal(const Interval &x)
+{
+    if (x.flag_error || (x.lower <= 0 && x.upper >= 0))
+        return unboundedInterval();
+    return makeInterval(1/x.upper, 1/x.lower);
+}
+
+double square(double x) { return x*x; }
+
+Interval affine(const Interval &x, double scale, double offset)
+{
+    // scale*x + offset
+    if (x.flag_error)
+        return x;
+    double a = scale*x.lower + offset;
+    double b = scale*x.upper + offset;
+    return widened(makeInterval(a < b ? a : b, a < b ? b : a));
+}
+
+Interval withinDomain(const Interval &x, double lower, double upper)
+{
+    // outside of [lower, upper] the function has no real value, or a pole
+    if (x.flag_error || x.lower < lower || x.upper > upper)
+        return unboundedInterval();
+    return x;
+}
+
+} // namespace
+
+
+//	Registry
+//	---------
+
+const FunctionEntry FunctionRegistry::s_entries[FunctionCount] = {
+    //	trig functions
+    { "sin",		1,	scalarOf<sin>,					batchOf<MathKernels::vectorSin>,					0,					20 },
+    { "cos",		1,	scalarOf<cos>,					batchOf<MathKernels::vectorCos>,					0,					20 },
+    { "tan",		1,	scalarOf<tan>,					batchOf<MathKernels::vectorTan>,					0,					20 },
+    { "sec",		1,	scalarReciprocal<cos>,			batchReciprocal<MathKernels::vectorCos>,			poleAtInfinity,		24 },
+    { "csc",		1,	scalarReciprocal<sin>,			batchReciprocal<MathKernels::vectorSin>,			poleAtInfinity,		24 },
+    { "cot",		1,	scalarReciprocal<tan>,			batchReciprocal<MathKernels::vectorTan>,			poleAtInfinity,		24 },
+    { "sinh",		1,	scalarOf<sinh>,					batchOf<MathKernels::vectorSinh>,					0,					20 },
+    { "cosh",		1,	scalarOf<cosh>,					batchOf<MathKernels::vectorCosh>,					0,					20 },
+    { "tanh",		1,	scalarOf<tanh>,					batchOf<MathKernels::vectorTanh>,					0,					20 },
+    { "sech",		1,	scalarReciprocal<cosh>,			batchReciprocal<MathKernels::vectorCosh>,			0,					24 },
+    { "csch",		1,	scalarReciprocal<sinh>,			batchReciprocal<MathKernels::vectorSinh>,			poleAtZero,			24 },
+    { "coth",		1,	scalarReciprocal<tanh>,			batchReciprocal<MathKernels::vectorTanh>,			poleAtZero,			24 },
+
+    //	inverse trig functions
+    { "arcsin",		1,	scalarOf<asin>,					batchOf<MathKernels::vectorArcsin>,					0,					20 },
+    { "arccos",		1,	scalarOf<acos>,					batchOf<MathKernels::vectorArccos>,					0,					20 },
+    { "arctan",		1,	scalarOf<atan>,					batchOf<MathKernels::vectorArctan>,					0,					20 },
+    { "arcsec",		1,	scalarOfReciprocal<acos>,		batchOfReciprocal<MathKernels::vectorArccos>,		poleAtZero,			24 },
+    { "arccsc",		1,	scalarOfReciprocal<asin>,		batchOfReciprocal<MathKernels::vectorArcsin>,		poleAtZero,			24 },
+    { "arccot",		1,	scalarOfReciprocal<atan>,		batchOfReciprocal<MathKernels::vectorArctan>,		poleAtZero,			24 },
+    { "arcsinh",	1,	scalarOf<asinh>,				batchOf<MathKernels::vectorArcsinh>,				0,					20 },
+    { "arccosh",	1,	scalarOf<acosh>,				batchOf<MathKernels::vectorArccosh>,				0,					20 },
+    { "arctanh",	1,	scalarOf<atanh>,				batchOf<MathKernels::vectorArctanh>,				0,					20 },
+    { "arcsech",	1,	scalarOfReciprocal<acosh>,		batchOfReciprocal<MathKernels::vectorArccosh>,		poleAtZero,			24 },
+    { "arccsch",	1,	scalarOfReciprocal<asinh>,		batchOfReciprocal<MathKernels::vectorArcsinh>,		poleAtZero,			24 },
+    { "arccoth",	1,	scalarOfReciprocal<atanh>,		batchOfReciprocal<MathKernels::vectorArctanh>,		poleAtZero,			24 },
+
+    //	exponential and logarithmic functions
+    { "exp",		1,	scalarOf<exp>,					batchOf<MathKernels::vectorExp>,					0,					20 },
+    { "ln",			1,	scalarOf<log>,					batchOf<MathKernels::vectorLn>,						poleAtZero,			20 },
+    { "log",		1,	scalarOf<log10>,				batchOf<MathKernels::vectorLog>,					poleAtZero,			20 },
+
+    //	other
+    { "min",		2,	scalarMin,						batchMin,											0,					1 },
+    { "max",		2,	scalarMax,						batchMax,											0,					1 },
+    { "abs",		1,	scalarOf<fabs>,					batchAbs,											0,					1 },
+    { "sqrt",		1,	scalarOf<sqrt>,					batchSquareRoot,									complexBelowZero,	4 },
+};
+
+FunctionCode FunctionRegistry::lookup(const string &name)
+{
+    FunctionCode function;
+
+    switch(hashName(name.c_str())){
+    case hashName("sin"):		function = FunctionSin;		break;
+    case hashName("cos"):		function = FunctionCos;		break;
+    case hashName("tan"):		function = FunctionTan;		break;
+    case hashName("sec"):		function = FunctionSec;		break;
+    case hashName("csc"):		function = FunctionCsc;		break;
+    case hashName("cot"):		function = FunctionCot;		break;
+    case hashName("sinh"):		function = FunctionSinh;	break;
+    case hashName("cosh"):		function = FunctionCosh;	break;
+    case hashName("tanh"):		function = FunctionTanh;	break;
+    case hashName("sech"):		function = FunctionSech;	break;
+    case hashName("csch"):		function = FunctionCsch;	break;
+    case hashName("coth"):		function = FunctionCoth;	break;
+    case hashName("arcsin"):	function = FunctionArcsin;	break;
+    case hashName("arccos"):	function = FunctionArccos;	break;
+    case hashName("arctan"):	function = FunctionArctan;	break;
+    case hashName("arcsec"):	function = FunctionArcsec;	break;
+    case hashName("arccsc"):	function = FunctionArccsc;	break;
+    case hashName("arccot"):	function = FunctionArccot;	break;
+    case hashName("arcsinh"):	function = FunctionArcsinh;	break;
+    case hashName("arccosh"):	function = FunctionArccosh;	break;
+    case hashName("arctanh"):	function = FunctionArctanh;	break;
+    case hashName("arcsech"):	function = FunctionArcsech;	break;
+    case hashName("arccsch"):	function = FunctionArccsch;	break;
+    case hashName("arccoth"):	function = FunctionArccoth;	break;
+    case hashName("exp"):		function = FunctionExp;		break;
+    case hashName("ln"):		function = FunctionLn;		break;
+    case hashName("log"):		function = FunctionLog;		break;
+    case hashName("min"):		function = FunctionMin;		break;
+    case hashName("max"):		function = FunctionMax;		break;
+    case hashName("abs"):		function = FunctionAbs;		break;
+    case hashName("sqrt"):		function = FunctionSqrt;	break;
+    default:					return FunctionNone;
+    }
+
+    // other names may have the same hash
+    return (name == s_entries[function].name) ? function : FunctionNone;
+}
+
+bool FunctionRegistry::isFunction(const string &name) { return lookup(name) != FunctionNone; }
+
+const FunctionEntry &FunctionRegistry::entry(int function)
+{
+    assert(function >= 0 && function < FunctionCount && "FunctionRegistry: Unknown function");
+    return s_entries[function];
+}
+
+
+//	Evaluation
+//	-----------
+
+double FunctionRegistry::evaluate(int function, double lhs, double rhs, PointError &error)
+{
+    /*!	Evaluates a function at a single point; the math error, if any, is
+        returned in error.*/
+
+    const FunctionEntry &function_entry = entry(function);
+    double result = function_entry.scalar(lhs, rhs);
+
+    error = 0;
+    if (function_entry.domain != 0)
+        function_entry.domain(&lhs, &rhs, &result, &error, 1);
+    flagNaNs(&result, &error, 1);
+    return result;
+}
+
+Interval FunctionRegistry::bound(int function, const Interval &lhs, const Interval &rhs)
+{
+    /*!	Bounds the values of a function over intervals of its arguments. The
+        interval is flagged if a math error may occur in it, and is unbounded
+        if the function has no bounds.*/
+
+    if (lhs.flag_error || (entry(function).arity == 2 && rhs.flag_error))
+        return unboundedInterval();
+
+    switch(function){
+    case FunctionSin:		return sinBounds(lhs);
+    case FunctionCos:		return cosBounds(lhs);
+    case FunctionTan:		return tanBounds(lhs);
+    case FunctionSec:		return reciprocal(cosBounds(lhs));
+    case FunctionCsc:		return reciprocal(sinBounds(lhs));
+    case FunctionCot:		return reciprocal(tanBounds(lhs));
+    case FunctionSinh:		return increasing<sinh>(lhs);
+    case FunctionCosh:		return evenBounds(lhs, cosh);
+    case FunctionTanh:		return increasing<tanh>(lhs);
+    case FunctionSech:		return reciprocal(evenBounds(lhs, cosh));
+    case FunctionCsch:		return reciprocal(increasing<sinh>(lhs));
+    case FunctionCoth:		return reciprocal(increasing<tanh>(lhs));
+    case FunctionArcsin:	return increasing<asin>(withinDomain(lhs, -1, 1));
+    case FunctionArccos:	return decreasing<acos>(withinDomain(lhs, -1, 1));
+    case FunctionArctan:	return increasing<atan>(lhs);
+    case FunctionArcsec:	return decreasing<acos>(withinDomain(reciprocal(lhs), -1, 1));
+    case FunctionArccsc:	return increasing<asin>(withinDomain(reciprocal(lhs), -1, 1));
+    case FunctionArccot:	return increasing<atan>(reciprocal(lhs));
+    case FunctionArcsinh:	return increasing<asinh>(lhs);
+    case FunctionArccosh:	return increasing<acosh>(withinDomain(lhs, 1, INFINITY));
+    case FunctionArctanh:	return increasing<atanh>(withinDomain(lhs, nextafter(-1.0, 0.0), nextafter(1.0, 0.0)));
+    case FunctionArcsech:	return increasing<acosh>(withinDomain(reciprocal(lhs), 1, INFINITY));
+    case FunctionArccsch:	return increasing<asinh>(reciprocal(lhs));
+    case FunctionArccoth:	return increasing<atanh>(withinDomain(reciprocal(lhs), nextafter(-1.0, 0.0), nextafter(1.0, 0.0)));
+    case FunctionExp:		return increasing<exp>(lhs);
+    case FunctionLn:		return increasing<log>(withinDomain(lhs, nextafter(0.0, 1.0), INFINITY));
+    case FunctionLog:		return increasing<log10>(withinDomain(lhs, nextafter(0.0, 1.0), INFINITY));
+    case FunctionMin:		return makeInterval(fmin(lhs.lower, rhs.lower), fmin(lhs.upper, rhs.upper));
+    case FunctionMax:		return makeInterval(fmax(lhs.lower, rhs.lower), fmax(lhs.upper, rhs.upper));
+    case FunctionAbs:		return evenBounds(lhs, fabs);
+    case FunctionSqrt:		return increasing<sqrt>(withinDomain(lhs, 0, INFINITY));
+    default:				return unboundedInterval();
+    }
+}
+
+void FunctionRegistry::boundDerivative(int function, const Interval &lhs, const Interval &rhs, const Interval &value, Interval &d_lhs, Interval &d_rhs)
+{
+    /*!	Bounds the derivatives of a function with respect to each of its
+        arguments over intervals of them, where its values lie in value.
+        Functions whose derivatives are not bounded give unbounded intervals.*/
+
+    d_rhs = makeInterval(0, 0);
+    if (lhs.flag_error || value.flag_error || (entry(function).arity == 2 && rhs.flag_error)){
+        d_lhs = d_rhs = unboundedInterval();
+        return;
+    }
+
+    switch(function){
+    case FunctionSin:		d_lhs = cosBounds(lhs);												return;
+    case FunctionCos:		d_lhs = affine(sinBounds(lhs), -1, 0);								return;
+    case FunctionTan:		d_lhs = affine(evenBounds(value, square), 1, 1);					return;
+    case FunctionSinh:		d_lhs = evenBounds(lhs, cosh);										return;
+    case FunctionCosh:		d_lhs = increasing<sinh>(lhs);										return;
+    case FunctionTanh:		d_lhs = affine(evenBounds(value, square), -1, 1);					return;
+    case FunctionArctan:	d_lhs = reciprocal(affine(evenBounds(lhs, square), 1, 1));			return;
+    case FunctionArcsinh:	d_lhs = reciprocal(increasing<sqrt>(affine(evenBounds(lhs, square), 1, 1)));	return;
+    case FunctionExp:		d_lhs = value;														return;
+    case FunctionLn:		d_lhs = reciprocal(lhs);											return;
+    case FunctionLog:		d_lhs = affine(reciprocal(lhs), 1/log(10.0), 0);					return;
+    case FunctionSqrt:		d_lhs = reciprocal(affine(value, 2, 0));							return;
+    case FunctionAbs:
+        d_lhs = (lhs.lower > 0) ? makeInterval(1, 1) : (lhs.upper < 0) ? makeInterval(-1, -1) : makeInterval(-1, 1);
+        return;
+    case FunctionMin:
+    case FunctionMax:
+        {
+            // the argument returned, if it is the same over the intervals
+            bool flag_lhs_below = lhs.upper < rhs.lower;
+            bool flag_rhs_below = rhs.upper < lhs.lower;
+            if (!flag_lhs_below && !flag_rhs_below){
+                d_lhs = d_rhs = makeInterval(0, 1);
+                return;
+            }
+            bool flag_returns_lhs = (function == FunctionMin) == flag_lhs_below;
+            d_lhs = flag_returns_lhs ? makeInterval(1, 1) : makeInterval(0, 0);
+            d_rhs = flag_returns_lhs ? makeInterval(0, 0) : makeInterval(1, 1);
+            return;
+        }
+    default:				d_lhs = unboundedInterval();										return;
+    }
+}
+
+void FunctionRegistry::derivative(int function, double lhs, double rhs, double value, double &d_lhs, double &d_rhs)
+{
+    /*!	Writes the derivatives of a function with respect to each of its
+        arguments at (lhs, rhs), where it evaluates to value. They are not
+        finite where the function has no derivative; min and max take the
+        derivative of the argument they return, and abs has none at 0.*/
+
+    d_rhs = 0;
+    switch(function){
+    case FunctionSin:		d_lhs = cos(lhs);								return;
+    case FunctionCos:		d_lhs = -sin(lhs);								return;
+    case FunctionTan:		d_lhs = 1 + value*value;						return;
+    case FunctionSec:		d_lhs = value*tan(lhs);							return;
+    case FunctionCsc:		d_lhs = -value/tan(lhs);						return;
+    case FunctionCot:		d_lhs = -(1 + value*value);						return;
+    case FunctionSinh:		d_lhs = cosh(lhs);								return;
+    case FunctionCosh:		d_lhs = sinh(lhs);								return;
+    case FunctionTanh:		d_lhs = 1 - value*value;						return;
+    case FunctionSech:		d_lhs = -value*tanh(lhs);						return;
+    case FunctionCsch:		d_lhs = -value/tanh(lhs);						return;
+    case FunctionCoth:		d_lhs = 1 - value*value;						return;
+    case FunctionArcsin:	d_lhs = 1/sqrt(1 - lhs*lhs);					return;
+    case FunctionArccos:	d_lhs = -1/sqrt(1 - lhs*lhs);					return;
+    case FunctionArctan:	d_lhs = 1/(1 + lhs*lhs);						return;
+    case FunctionArcsec:	d_lhs = 1/(fabs(lhs)*sqrt(lhs*lhs - 1));		return;
+    case FunctionArccsc:	d_lhs = -1/(fabs(lhs)*sqrt(lhs*lhs - 1));		return;
+    case FunctionArccot:	d_lhs = -1/(1 + lhs*lhs);						return;
+    case FunctionArcsinh:	d_lhs = 1/sqrt(lhs*lhs + 1);					return;
+    case FunctionArccosh:	d_lhs = 1/sqrt(lhs*lhs - 1);					return;
+    case FunctionArctanh:	d_lhs = 1/(1 - lhs*lhs);						return;
+    case FunctionArcsech:	d_lhs = -1/(fabs(lhs)*sqrt(1 - lhs*lhs));		return;
+    case FunctionArccsch:	d_lhs = -1/(fabs(lhs)*sqrt(1 + lhs*lhs));		return;
+    case FunctionArccoth:	d_lhs = 1/(1 - lhs*lhs);						return;
+    case FunctionExp:		d_lhs = value;									return;
+    case FunctionLn:		d_lhs = 1/lhs;									return;
+    case FunctionLog:		d_lhs = 1/(lhs*log(10.0));						return;
+    case FunctionMin:		d_lhs = (rhs < lhs) ? 0 : 1;	d_rhs = 1 - d_lhs;	return;
+    case FunctionMax:		d_lhs = (lhs < rhs) ? 0 : 1;	d_rhs = 1 - d_lhs;	return;
+    case FunctionAbs:		d_lhs = (lhs == 0) ? NAN : ((lhs < 0) ? -1 : 1);	return;
+    case FunctionSqrt:		d_lhs = 0.5/value;								return;
+    default:				d_lhs = NAN;									return;
+    }
+}
+
+void FunctionRegistry::evaluate(int function, const double *lhs, const double *rhs, double *results, PointError *errors, int count)
+{
+    /*!	Evaluates a function over a block of points. Points which did not
+        already have an error get the error of the function, if any; errors
+        are not classified if errors is 0. The kernels run in the accuracy
+        mode selected in MathKernels. results may not overlap the arguments.*/
+
+    const FunctionEntry &function_entry = entry(function);
+    function_entry.batch(lhs, rhs, results, count);
+
+    if (errors == 0)
+        return;
+    if (function_entry.domain != 0)
+        function_entry.domain(lhs, rhs, results, errors, count);
+    flagNaNs(results, errors, count);
+}
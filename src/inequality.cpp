@@ -1,6 +1,9 @@
 #include "include/inequality.h"
 
 
+InequalityEvaluation Inequality::s_evaluation = EvaluationGrid;
+int Inequality::s_refinementDepth = 0;
+
 Inequality::Inequality(string expression1, InequalitySymbol symbol, string expression2) :
  flag_Initialized(true),
  m_Precision(0),
@@ -19,13 +22,40 @@ void Inequality::clearVariables()
 {
     m_LeftExpression.clearVariables();
     m_RightExpression.clearVariables();
+    m_Variables.clear();
+    m_Order.clear();
 }
 
-void Inequality::addVariable(Variable variable)
+void Inequality::addVariable(const Variable &variable)
 {
     assert(flag_Initialized);
     m_LeftExpression.addVariable(variable);
     m_RightExpression.addVariable(variable);
+    m_Variables.push_back(variable);
+    m_Order.push_back(static_cast<int>(m_Variables.size()) - 1);
+}
+
+void Inequality::setGrid(const Variable &x_variable, const Variable &y_variable)
+{
+    /*!	Orders the loops of the comparison so that x turns fastest and y
+        next; the other variables keep the order in which they were added.
+        A variable which was not added is ignored.*/
+
+    int variable_count = static_cast<int>(m_Variables.size());
+    int x_slot = variable_count;
+    int y_slot = variable_count;
+    for (int j = 0; j < variable_count; j++){
+        if (m_Variables[j].name() == x_variable.name() && x_slot == variable_count) { x_slot = j; }
+        if (m_Variables[j].name() == y_variable.name() && y_slot == variable_count) { y_slot = j; }
+    }
+
+    m_Order.clear();
+    for (int j = 0; j < variable_count; j++){
+        if (j != x_slot && j != y_slot)
+            m_Order.push_back(j);
+    }
+    if (y_slot < variable_count && y_slot != x_slot) { m_Order.push_back(y_slot); }
+    if (x_slot < variable_count) { m_Order.push_back(x_slot); }
 }
 
 void Inequality::setInequality(string left_expression, int symbol, string right_expression)
@@ -61,12 +91,24 @@ void Inequality::setPrecision(double value){ m_Precision = value; }
 
 void Inequality::setCancelPointer(bool *ptr) { flag_Cancel = ptr; }
 
+void Inequality::setEvaluation(InequalityEvaluation evaluation) { s_evaluation = evaluation; }
+
+void Inequality::setRefinementDepth(int depth)
+{
+    /*!	Sets the number of times a boundary cell may be split, 0 to not
+        refine; each split doubles the sub-points per side, up to
+        Region::s_maxRefinement.*/
+
+    assert(depth >= 0 && (1 << depth) <= Region::s_maxRefinement && "Inequality: Refinement depth out of range");
+    s_refinementDepth = depth;
+}
+
 //	Getters
 //	--------
 
-vector<int> Inequality::getProblemElements_ExpressionLHS(){ return m_LeftExpression.getProblemElements_Expression(); }
+const vector<int> &Inequality::getProblemElements_ExpressionLHS(){ return m_LeftExpression.getProblemElements_Expression(); }
 
-vector<int> Inequality::getProblemElements_ExpressionRHS(){ return m_RightExpression.getProblemElements_Expression(); }
+const vector<int> &Inequality::getProblemElements_ExpressionRHS(){ return m_RightExpression.getProblemElements_Expression(); }
 
 string Inequality::getTermLHS(int nTerm){ return m_LeftExpression.getTerm(nTerm); }
 
@@ -80,92 +122,969 @@ int Inequality::getNumTermsLHS(){ return m_LeftExpression.getNumTerms(); }
 
 int Inequality::getNumTermsRHS(){ return m_RightExpression.getNumTerms(); }
 
-bool Inequality::getXBeforeY(Variable mXVar, Variable mYVar) { return m_LeftExpression.isXBeforeY(mXVar, mYVar); }
+InequalityEvaluation Inequality::evaluation() { return s_evaluation; }
+
+int Inequality::refinementDepth() { return s_refinementDepth; }
+
 
 
 //	Evaluation
 //	-----------
 
-vector<bool> Inequality::evaluate()
+Region Inequality::evaluate(const Region *mask)
 {
-    vector<bool> plot_points;
+    /*!	Compares the two sides over the grid (see evaluateRegion), then
+        refines the boundary of the region if a refinement depth is set. A
+        side with a math error is compared as 0, so the problem points are
+        taken out of the points of the region and only shown as problems.*/
 
-    m_LeftExpression.setCancelPointer(flag_Cancel);
-    m_RightExpression.setCancelPointer(flag_Cancel);
+    Region region = evaluateRegion(mask);
+    if (!*flag_Cancel && !region.isEmpty())
+        refineBoundary(region, mask);
+    region.excludeProblems();
+    return *flag_Cancel ? Region() : region;
+}
 
-    m_LeftResults = m_LeftExpression.evaluateAll();
-    m_RightResults = m_RightExpression.evaluateAll();
 
-    for (unsigned int i = 0; i < m_LeftResults.size(); i++){
-        switch (m_Sym){
-        case SmallerThan:
-            plot_points.push_back(m_LeftResults[i] < m_RightResults[i]);
-            break;
-        case GreaterThan:
-            plot_points.push_back(m_LeftResults[i] > m_RightResults[i]);
-            break;
-        case SmallerThanEqual:
-            plot_points.push_back(m_LeftResults[i] <= m_RightResults[i]);
+double Inequality::estimateCost()
+{
+    // both sides, and their comparison
+    return m_LeftExpression.estimateCost() + m_RightExpression.estimateCost() + 1;
+}
+
+double Inequality::estimateSelectivity(int samples)
+{
+    /*!	Estimates the part of the grid in which the inequality holds, from
+        about samples points spread evenly over it. The points are compared
+        by a copy of the inequality, so the warnings of the sample are not
+        reported with those of the evaluation.*/
+
+    Region region = createRegion();
+    if (region.isEmpty())
+        return 0;
+
+    // every step-th column and row
+    int side = max(static_cast<int>(sqrt(static_cast<double>(samples))), 1);
+    int column_step = max(region.width()/side, 1);
+    int row_step = max(region.height()/side, 1);
+
+    Region mask(region.xVariable(), region.yVariable(), region.height());
+    for (int row = 0; row < region.height(); row += row_step){
+        for (int column = 0; column < region.width(); column += column_step) { mask.setPoint(column, row, true); }
+    }
+
+    Inequality sample(getExpressionLHS(), m_Sym, getExpressionRHS());
+    sample.setPrecision(m_Precision);
+    sample.setCancelPointer(flag_Cancel);
+    for (unsigned int j = 0; j < m_Variables.size(); j++) { sample.addVariable(m_Variables[j]); }
+    sample.m_Order = m_Order;
+    sample.m_LeftExpression.setCancelPointer(flag_Cancel);
+    sample.m_RightExpression.setCancelPointer(flag_Cancel);
+
+    sample.evaluateMasked(mask, region);
+    return static_cast<double>(region.count())/mask.count();
+}
+
+
+//	Boundary
+//	---------
+
+void Inequality::prepareBoundary()
+{
+    /*!	Binds the variables of both sides for fieldGradient; called once
+        before the calls to projectOnBoundary and slack, after setGrid. The
+        variables other than x and y take their first value.*/
+
+    m_LeftExpression.prepareBatches();
+    m_RightExpression.prepareBatches();
+
+    m_PointValues.resize(m_Variables.size());
+    for (unsigned int j = 0; j < m_Variables.size(); j++) { m_PointValues[j] = m_Variables[j].value(0); }
+}
+
+bool Inequality::projectOnBoundary(double x0, double y0, double x1, double y1, double &fraction)
+{
+    /*!	Finds the point of the segment from (x0, y0) to (x1, y1), as the
+        fraction of the way along it, at which the sides are equal, starting
+        from fraction. The ends must be on either side of the boundary. Each
+        step is Newton's along the segment, from the gradient of the field,
+        kept within the bracket of the root, or else bisects the bracket.
+        Returns false, leaving fraction, if the ends are not on either side
+        or a point of the segment has a math error.*/
+
+    DualNumber first, last;
+    if (!fieldGradient(x0, y0, first) || !fieldGradient(x1, y1, last))
+        return false;
+    if ((first.value < 0) == (last.value < 0))
+        return false;
+
+    double dx = x1 - x0, dy = y1 - y0;
+    double low = 0, high = 1;			// the field has the sign of first at low
+    double t = (fraction > 0 && fraction < 1) ? fraction : 0.5;
+
+    for (int step = 0; step < s_projectionSteps; step++){
+        DualNumber field;
+        if (!fieldGradient(x0 + t*dx, y0 + t*dy, field))
+            return false;
+        if (field.value == 0)
             break;
-        case GreaterThanEqual:
-            plot_points.push_back(m_LeftResults[i] >= m_RightResults[i]);
+
+        if ((field.value < 0) == (first.value < 0)) { low = t; }
+        else { high = t; }
+
+        double next = t - field.value/(field.dx*dx + field.dy*dy);
+        if (!(next > low && next < high))
+            next = 0.5*(low + high);		// also when the slope is 0 or not finite
+
+        bool flag_converged = fabs(next - t) <= 1e-12;
+        t = next;
+        if (flag_converged)
             break;
-        case ApproxEqual:
-            {
-                double diff = (m_LeftResults[i]-m_RightResults[i])*(m_LeftResults[i]-m_RightResults[i]);
-                plot_points.push_back((m_Precision*m_Precision) >= diff);
+    }
+
+    fraction = t;
+    return true;
+}
+
+double Inequality::slack(double x, double y, double x_scale, double y_scale)
+{
+    /*!	Returns the distance of (x, y) from the boundary to first order, the
+        field divided by the length of its gradient, in units of x_scale in
+        x and y_scale in y (e.g. the steps of the grid): negative where the
+        inequality holds, positive where it fails, NaN where it is not known.*/
+
+    DualNumber field;
+    if (!fieldGradient(x, y, field))
+        return NAN;
+
+    double length = sqrt(field.dx*x_scale*field.dx*x_scale + field.dy*y_scale*field.dy*y_scale);
+    return field.value/length;
+}
+
+bool Inequality::fieldGradient(double x, double y, DualNumber &field)
+{
+    /*!	The field of the comparison at (x, y), in double precision (see
+        fieldValue), with its derivatives in x and y. Returns false if
+        either side has a math error there.*/
+
+    int variable_count = static_cast<int>(m_Order.size());
+    assert(variable_count >= 2 && m_PointValues.size() == m_Variables.size() && "fieldGradient: Call setGrid and prepareBoundary first.");
+
+    int x_slot = m_Order[variable_count-1];
+    int y_slot = m_Order[variable_count-2];
+    m_PointValues[x_slot] = x;
+    m_PointValues[y_slot] = y;
+
+    PointError left_error, right_error;
+    DualNumber left = m_LeftExpression.evaluateDual(m_PointValues, x_slot, y_slot, left_error);
+    DualNumber right = m_RightExpression.evaluateDual(m_PointValues, x_slot, y_slot, right_error);
+    if (left_error != 0 || right_error != 0)
+        return false;
+
+    double sign = (m_Sym == GreaterThan || m_Sym == GreaterThanEqual) ? -1 : 1;
+    if (m_Sym == ApproxEqual && left.value < right.value)
+        sign = -1;
+
+    field.value = sign*(left.value - right.value);
+    field.dx = sign*(left.dx - right.dx);
+    field.dy = sign*(left.dy - right.dy);
+    if (m_Sym == ApproxEqual)
+        field.value -= m_Precision;
+    return field.value - field.value == 0;
+}
+
+
+//	Private Functions
+//	------------------
+
+Region Inequality::evaluateRegion(const Region *mask)
+{
+    /*!	With EvaluationIntervals, the columns of the grid in which the
+        comparison is monotonic in y are first decided by bisection (see
+        bisectColumns), and only the points of the other columns are
+        compared (see evaluatePoints); otherwise every point is compared.*/
+
+    m_LeftExpression.setCancelPointer(flag_Cancel);
+    m_RightExpression.setCancelPointer(flag_Cancel);
+
+    Region region = createRegion();
+    if (s_evaluation != EvaluationIntervals || !canBoundCells(region))
+        return evaluatePoints(mask);
+
+    region.enableField();
+    Region open = bisectColumns(region, mask);
+    if (*flag_Cancel)
+        return Region();
+    if (open.count() == 0)
+        return region;
+
+    Region rest = evaluatePoints(&open);
+    if (rest.isEmpty())
+        return Region();
+    region.unite(rest);
+    return region;
+}
+
+Region Inequality::evaluatePoints(const Region *mask)
+{
+    /*!	Compares the two sides at every combination of the variables, in the
+        order of m_Order (see setGrid). Each side is only evaluated over the
+        variables it references (on a plot: x, y, both or neither) and its
+        results are broadcast over the others while comparing, so a side of
+        only x costs one evaluation per x rather than one per point. The
+        results of each side are read in place from its expression.
+
+        The innermost loop is x, the columns of the region, and the next is y,
+        its rows; an inequality of fewer variables gives a region of a
+        single row or point.
+
+        If a mask on the same grid is given, only the points of the mask are
+        compared (see evaluateMasked); a mask of most of the grid is compared
+        as a whole grid and the result clipped to it (see Region::clip).
+        Either way the other points are left empty and are not checked for
+        problems.
+
+        With EvaluationIntervals, rectangles of the grid are first decided
+        from the bounds of both sides (see boundCells), and only the points
+        left undecided are compared; if they are most of the grid, the grid
+        is evaluated as usual.
+
+        The field of the region is kept at the compared points (see
+        fieldValue); the points decided from bounds, or outside of the mask,
+        are left unknown.*/
+
+    Region region = createRegion();
+    region.enableField();
+    if (s_evaluation == EvaluationIntervals && canBoundCells(region)){
+        Region undecided = boundCells(region, mask);
+        if (maskIsSparse(undecided)){
+            evaluateMasked(undecided, region);
+            return *flag_Cancel ? Region() : region;
+        }
+        region = createRegion();
+        region.enableField();
+    }
+    if (mask != 0 && mask->sameGrid(region) && maskIsSparse(*mask)){
+        evaluateMasked(*mask, region);
+        return *flag_Cancel ? Region() : region;
+    }
+
+    const vector<double> &left_results = m_LeftExpression.evaluateDependent();
+    const vector<double> &right_results = m_RightExpression.evaluateDependent();
+
+    const vector<int> &left_strides = m_LeftExpression.getResultStrides();
+    const vector<int> &right_strides = m_RightExpression.getResultStrides();
+    vector<bool> flag_left_problem = problemFlags(m_LeftExpression.getProblemElements_Result(), left_results.size());
+    vector<bool> flag_right_problem = problemFlags(m_RightExpression.getProblemElements_Result(), right_results.size());
+
+    if (*flag_Cancel || left_results.empty() || right_results.empty())
+        return Region();
+
+    // the innermost loop is a strided run through the results of each side
+    int variable_count = static_cast<int>(m_Order.size());
+    int row_count = region.height();
+    int inner = (variable_count > 0) ? m_Order.back() : 0;
+    int inner_count = (variable_count > 0) ? m_Variables[inner].elements() : 1;
+    int inner_left = (variable_count > 0) ? left_strides[inner] : 0;
+    int inner_right = (variable_count > 0) ? right_strides[inner] : 0;
+    assert(inner_count == region.width() && "Inequality: Domain of x was not created");
+    if (region.isEmpty())
+        return region;
+
+    // odometer over the outer loops; left and right index the first point of the run
+    vector<int> position(variable_count, 0);
+    int left = 0;
+    int right = 0;
+    for (int row = 0; row < row_count; row++){
+        RegionWord *points = region.pointRow(row);
+        RegionWord *problems = region.problemRow(row);
+        float *field = region.fieldRow(row);
+
+        for (int k = 0; k < inner_count; k++){
+            int l = left + k*inner_left;
+            int r = right + k*inner_right;
+            RegionWord bit = RegionWord(1) << (k % Region::s_wordBits);
+            if (compare(left_results[l], right_results[r]))
+                points[k/Region::s_wordBits] |= bit;
+            if (flag_left_problem[l] || flag_right_problem[r])
+                problems[k/Region::s_wordBits] |= bit;
+            // the sides of a problem point are 0 (see Expression::evaluateBatch), so its field is not known
+            field[k] = (flag_left_problem[l] || flag_right_problem[r]) ? NAN : fieldValue(left_results[l], right_results[r]);
+        }
+
+        for (int d = variable_count - 2; d >= 0; d--){
+            int j = m_Order[d];
+            int elements = m_Variables[j].elements();
+            position[d]++;
+            left += left_strides[j];
+            right += right_strides[j];
+            if (position[d] < elements)
                 break;
+
+            position[d] = 0;
+            left -= left_strides[j]*elements;
+            right -= right_strides[j]*elements;
+        }
+    }
+
+    if (mask != 0 && mask->sameGrid(region))
+        region.clip(*mask);
+    return region;
+}
+
+Region Inequality::createRegion()
+{
+    /*!	Returns an empty region on the grid of the comparison: x columns and
+        y rows, the other variables repeating the rows.*/
+
+    int variable_count = static_cast<int>(m_Order.size());
+    Variable single_value("", 0, 0, 1);
+    const Variable &x_variable = (variable_count > 0) ? m_Variables[m_Order[variable_count-1]] : single_value;
+    const Variable &y_variable = (variable_count > 1) ? m_Variables[m_Order[variable_count-2]] : single_value;
+
+    int row_count = 1;
+    for (int d = 0; d < variable_count - 1; d++) { row_count *= m_Variables[m_Order[d]].elements(); }
+    return Region(x_variable, y_variable, row_count);
+}
+
+bool Inequality::maskIsSparse(const Region &mask)
+{
+    /*!	Masked evaluation computes every point in full, while the grid
+        evaluation computes the parts of a side which depend on y alone once
+        per row; masks of more than about half of the grid are evaluated
+        faster as a whole grid.*/
+
+    double grid_points = static_cast<double>(mask.width())*mask.height();
+    return mask.count() < grid_points/2;
+}
+
+void Inequality::evaluateMasked(const Region &mask, Region &region)
+{
+    /*!	Compares the two sides only at the points of mask. The points are
+        gathered BATCH_SIZE at a time, with the value of every variable at
+        each point, and both sides are evaluated for them as one batch; rows
+        and words of the mask without points cost a test of the word.*/
+
+    m_LeftExpression.prepareBatches();
+    m_RightExpression.prepareBatches();
+
+    int variable_count = static_cast<int>(m_Order.size());
+    int outer_count = max(variable_count - 1, 0);
+    int inner = (variable_count > 0) ? m_Order.back() : 0;
+
+    // the values of each variable at the gathered points
+    vector<double> values(variable_count*BATCH_SIZE);
+    vector<BatchSpan> spans(variable_count);
+    for (int j = 0; j < variable_count; j++){
+        BatchSpan span = { &values[j*BATCH_SIZE], 1, 0 };
+        spans[j] = span;
+    }
+    int columns[BATCH_SIZE];
+    int rows[BATCH_SIZE];
+    int count = 0;
+
+    vector<double> x_values(region.width());
+    if (variable_count > 0) { m_Variables[inner].fill(0, region.width(), x_values.data()); }
+
+    vector<int> position(outer_count, 0);
+    vector<double> outer_values(outer_count);
+    for (int row = 0; row < region.height(); row++){
+        if (*flag_Cancel)
+            return;
+
+        for (int d = 0; d < outer_count; d++) { outer_values[d] = m_Variables[m_Order[d]].value(position[d]); }
+
+        const RegionWord *active = mask.pointRow(row);
+        for (int w = 0; w < mask.wordsPerRow(); w++){
+            for (RegionWord bits = active[w]; bits != 0; bits &= bits - 1){
+                int column = w*Region::s_wordBits + Region::lowestBit(bits);
+
+                for (int d = 0; d < outer_count; d++) { values[m_Order[d]*BATCH_SIZE + count] = outer_values[d]; }
+                if (variable_count > 0) { values[inner*BATCH_SIZE + count] = x_values[column]; }
+                columns[count] = column;
+                rows[count] = row;
+
+                if (++count == BATCH_SIZE){
+                    comparePoints(spans, count, columns, rows, region);
+                    count = 0;
+                }
             }
-        default:
-            assert (false && "Unknown inequality operator");
-            break;
+        }
+
+        // next combination of the outer variables
+        for (int d = outer_count - 1; d >= 0; d--){
+            if (++position[d] < m_Variables[m_Order[d]].elements())
+                break;
+            position[d] = 0;
+        }
+    }
+
+    if (count > 0)
+        comparePoints(spans, count, columns, rows, region);
+}
+
+Region Inequality::bisectColumns(Region &region, const Region *mask)
+{
+    /*!	Decides the columns of the grid in which the field is monotonic in y,
+        and returns the points which are left, within mask if it is given.
+        The derivative of the field in y is bounded over each column (see
+        slopeSign); where it does not change sign and no
+        point can have a math error, the comparison holds in a run of rows
+        from one end of the column, and the row at which it changes is found
+        by bisection, comparing one point per column and step for all of the
+        columns at once: log2 of the rows rather than every row. The field is
+        kept at the compared points and on both sides of the change.
+        ApproxEqual holds in a band, and is never bisected. Columns without
+        points of the mask are skipped.*/
+
+    m_LeftExpression.prepareBatches();
+    m_RightExpression.prepareBatches();
+
+    int width = region.width();
+    int height = region.height();
+    int x_slot = m_Order.back();
+    int y_slot = m_Order[m_Order.size()-2];
+    const Variable &x_variable = m_Variables[x_slot];
+    const Variable &y_variable = m_Variables[y_slot];
+
+    vector<Interval> bounds(m_Variables.size());
+    for (unsigned int j = 0; j < m_Variables.size(); j++){
+        double value = m_Variables[j].value(0);
+        bounds[j] = makeInterval(value, value);
+    }
+    double y0 = y_variable.value(0), y1 = y_variable.value(height - 1);
+    bounds[y_slot] = makeInterval(min(y0, y1), max(y0, y1));
+
+    // the monotonic columns, and whether the comparison holds in their first rows
+    vector<int> columns;
+    vector<bool> flag_holds_first;
+    Region open(region.xVariable(), region.yVariable(), height);
+    if (mask != 0 && !mask->sameGrid(region))
+        mask = 0;
+    for (int column = 0; column < width; column++){
+        if (mask != 0 && !mask->containsAny(column, 0, 1, height))
+            continue;
+
+        double x = x_variable.value(column);
+        bounds[x_slot] = makeInterval(x, x);
+        int sign = slopeSign(bounds, y_slot, min(y0, y1), max(y0, y1), s_slopeDepth);
+        if (sign == 0){
+            open.setRectangle(column, 0, 1, height);
+            continue;
+        }
+        columns.push_back(column);
+        flag_holds_first.push_back((sign > 0) == (y1 >= y0));	// the field rises along the column
+    }
+
+    // the first row of each column at which the comparison differs from its first rows
+    int count = static_cast<int>(columns.size());
+    vector<int> low(count, 0), high(count, height);
+    vector<int> probe_columns, probe_rows, probes;
+    for (bool flag_open = true; flag_open && !*flag_Cancel; ){
+        probe_columns.clear();
+        probe_rows.clear();
+        probes.clear();
+        for (int k = 0; k < count; k++){
+            if (low[k] < high[k]){
+                probe_columns.push_back(columns[k]);
+                probe_rows.push_back((low[k] + high[k])/2);
+                probes.push_back(k);
+            }
+        }
+
+        flag_open = !probes.empty();
+        comparePointList(probe_columns, probe_rows, region);
+        for (unsigned int p = 0; p < probes.size(); p++){
+            int k = probes[p];
+            if (region.contains(probe_columns[p], probe_rows[p]) == flag_holds_first[k]) { low[k] = probe_rows[p] + 1; }
+            else { high[k] = probe_rows[p]; }
+        }
+    }
+
+    // the rows on both sides of the change keep their field
+    probe_columns.clear();
+    probe_rows.clear();
+    for (int k = 0; k < count; k++){
+        for (int row = low[k] - 1; row <= low[k]; row++){
+            if (row >= 0 && row < height && region.field(columns[k], row) - region.field(columns[k], row) != 0){
+                probe_columns.push_back(columns[k]);
+                probe_rows.push_back(row);
+            }
+        }
+        if (flag_holds_first[k]) { region.setRectangle(columns[k], 0, 1, low[k]); }
+        else { region.setRectangle(columns[k], low[k], 1, height - low[k]); }
+    }
+    comparePointList(probe_columns, probe_rows, region);
+
+    // only the points of the mask are kept
+    if (mask != 0){
+        region.clip(*mask);
+        open.clip(*mask);
+    }
+    return open;
+}
+
+int Inequality::slopeSign(vector<Interval> &bounds, int slot, double lower, double upper, int depth)
+{
+    /*!	Returns 1 if the field does not decrease in the variable of slot
+        while it lies in [lower, upper], -1 if it does not increase, or 0 if
+        neither is known. Bounds of the derivative are wide where the
+        variable appears more than once (y*y*y for y^3), so a range over
+        which the sign is not known is halved, up to depth times.*/
+
+    bounds[slot] = makeInterval(lower, upper);
+    Interval slope = fieldSlope(bounds, slot);
+    if (!slope.flag_error && slope.lower >= 0)
+        return 1;
+    if (!slope.flag_error && slope.upper <= 0)
+        return -1;
+    if (depth == 0 || slope.flag_error)
+        return 0;
+
+    double middle = 0.5*(lower + upper);
+    int sign = slopeSign(bounds, slot, lower, middle, depth - 1);
+    if (sign == 0 || slopeSign(bounds, slot, middle, upper, depth - 1) != sign)
+        return 0;
+    return sign;
+}
+
+Interval Inequality::fieldSlope(const vector<Interval> &bounds, int slot)
+{
+    /*!	Bounds the derivative of the field (see fieldValue) with respect to
+        the variable of slot, where variable slot j lies in bounds[j]. The
+        field of ApproxEqual has no bounded derivative.*/
+
+    if (m_Sym == ApproxEqual)
+        return unboundedInterval();
+
+    Interval left = m_LeftExpression.evaluateSlope(bounds, slot);
+    Interval right = m_RightExpression.evaluateSlope(bounds, slot);
+    if (left.flag_error || right.flag_error)
+        return unboundedInterval();
+
+    if (m_Sym == GreaterThan || m_Sym == GreaterThanEqual)
+        return makeInterval(right.lower - left.upper, right.upper - left.lower);
+    return makeInterval(left.lower - right.upper, left.upper - right.lower);
+}
+
+void Inequality::comparePointList(const vector<int> &columns, const vector<int> &rows, Region &region)
+{
+    /*!	Compares the sides at the points (columns[k], rows[k]) of a grid
+        whose variables other than x and y have a single value, BATCH_SIZE
+        points at a time (see comparePoints).*/
+
+    int variable_count = static_cast<int>(m_Variables.size());
+    int x_slot = m_Order.back();
+    int y_slot = m_Order[m_Order.size()-2];
+
+    vector<double> values(variable_count*BATCH_SIZE);
+    vector<BatchSpan> spans(variable_count);
+    for (int j = 0; j < variable_count; j++){
+        BatchSpan span = { &values[j*BATCH_SIZE], 1, 0 };
+        spans[j] = span;
+        fill(values.begin() + j*BATCH_SIZE, values.begin() + (j + 1)*BATCH_SIZE, m_Variables[j].value(0));
+    }
+
+    int size = static_cast<int>(columns.size());
+    for (int start = 0; start < size; start += BATCH_SIZE){
+        int count = min(size - start, static_cast<int>(BATCH_SIZE));
+        for (int k = 0; k < count; k++){
+            values[x_slot*BATCH_SIZE + k] = m_Variables[x_slot].value(columns[start + k]);
+            values[y_slot*BATCH_SIZE + k] = m_Variables[y_slot].value(rows[start + k]);
+        }
+        comparePoints(spans, count, &columns[start], &rows[start], region);
+    }
+}
+
+void Inequality::comparePoints(const vector<BatchSpan> &spans, int count, const int *columns, const int *rows, Region &region)
+{
+    bool flag_holds[BATCH_SIZE], flag_problems[BATCH_SIZE];
+    float field[BATCH_SIZE];
+    compareBatch(spans, count, flag_holds, flag_problems, field);
+
+    for (int k = 0; k < count; k++){
+        if (flag_holds[k])
+            region.setPoint(columns[k], rows[k], true);
+        if (flag_problems[k])
+            region.setProblem(columns[k], rows[k], true);
+        if (region.hasField())
+            region.fieldRow(rows[k])[columns[k]] = field[k];
+    }
+}
+
+void Inequality::compareBatch(const vector<BatchSpan> &spans, int count, bool *flag_holds, bool *flag_problems, float *field)
+{
+    double left_results[BATCH_SIZE], right_results[BATCH_SIZE];
+    PointError left_errors[BATCH_SIZE], right_errors[BATCH_SIZE];
+
+    m_LeftExpression.evaluateBatch(spans, count, left_results, left_errors);
+    m_RightExpression.evaluateBatch(spans, count, right_results, right_errors);
+
+    for (int k = 0; k < count; k++){
+        flag_holds[k] = compare(left_results[k], right_results[k]);
+        flag_problems[k] = (left_errors[k] != 0 || right_errors[k] != 0);
+    }
+    if (field != 0){
+        for (int k = 0; k < count; k++) { field[k] = flag_problems[k] ? NAN : fieldValue(left_results[k], right_results[k]); }
+    }
+}
+
+bool Inequality::canBoundCells(const Region &region)
+{
+    /*!	Cells are bounded and refined over x and y, so every other variable
+        must have a single value, and both sides must have compiled.*/
+
+    return !region.isEmpty() && m_Order.size() >= 2 && region.height() == region.yVariable().domainSize()
+            && m_LeftExpression.isValid() && m_RightExpression.isValid();
+}
+
+Region Inequality::boundCells(Region &region, const Region *mask)
+{
+    /*!	Sets the points of the rectangles of the grid in which the comparison
+        holds everywhere, and returns the points which are left undecided,
+        within mask if it is given. The grid is split into quarters until
+        the bounds of the two sides decide a rectangle, or it is at most
+        s_leafSize points on a side; rectangles without points of the mask
+        are not bounded or split.*/
+
+    m_LeftExpression.prepareBatches();
+    m_RightExpression.prepareBatches();
+
+    // the variables other than x and y keep their single value
+    vector<Interval> bounds(m_Variables.size());
+    for (unsigned int j = 0; j < m_Variables.size(); j++){
+        double value = m_Variables[j].value(0);
+        bounds[j] = makeInterval(value, value);
+    }
+
+    Region undecided(region.xVariable(), region.yVariable(), region.height());
+    if (mask != 0 && !mask->sameGrid(region))
+        mask = 0;
+    refineCell(0, 0, region.width(), region.height(), bounds, mask, region, undecided);
+
+    // only the points of the mask are kept
+    if (mask != 0){
+        region.clip(*mask);
+        undecided.clip(*mask);
+    }
+    return undecided;
+}
+
+void Inequality::refineCell(int first_column, int first_row, int columns, int rows, vector<Interval> &bounds, const Region *mask, Region &region, Region &undecided)
+{
+    if (*flag_Cancel || (mask != 0 && !mask->containsAny(first_column, first_row, columns, rows)))
+        return;
+
+    const Variable &x_variable = m_Variables[m_Order.back()];
+    const Variable &y_variable = m_Variables[m_Order[m_Order.size()-2]];
+    double x0 = x_variable.value(first_column), x1 = x_variable.value(first_column + columns - 1);
+    double y0 = y_variable.value(first_row), y1 = y_variable.value(first_row + rows - 1);
+    bounds[m_Order.back()] = makeInterval(min(x0, x1), max(x0, x1));
+    bounds[m_Order[m_Order.size()-2]] = makeInterval(min(y0, y1), max(y0, y1));
+
+    int decision = compareIntervals(m_LeftExpression.evaluateInterval(bounds), m_RightExpression.evaluateInterval(bounds));
+    if (decision >= 0){
+        if (decision == 1)
+            region.setRectangle(first_column, first_row, columns, rows);
+        return;
+    }
+
+    if (columns <= s_leafSize && rows <= s_leafSize){
+        undecided.setRectangle(first_column, first_row, columns, rows);
+        return;
+    }
+
+    // quarters, or halves of a rectangle which is already narrow
+    int left_columns = (columns > s_leafSize) ? columns/2 : columns;
+    int top_rows = (rows > s_leafSize) ? rows/2 : rows;
+    refineCell(first_column, first_row, left_columns, top_rows, bounds, mask, region, undecided);
+    if (left_columns < columns)
+        refineCell(first_column + left_columns, first_row, columns - left_columns, top_rows, bounds, mask, region, undecided);
+    if (top_rows < rows){
+        refineCell(first_column, first_row + top_rows, left_columns, rows - top_rows, bounds, mask, region, undecided);
+        if (left_columns < columns)
+            refineCell(first_column + left_columns, first_row + top_rows, columns - left_columns, rows - top_rows, bounds, mask, region, undecided);
+    }
+}
+
+int Inequality::compareIntervals(const Interval &left, const Interval &right)
+{
+    /*!	Returns 1 if the comparison holds for every pair of values in the
+        bounds, 0 if it holds for none, and -1 if the bounds do not decide
+        it or a side may have a math error.*/
+
+    if (left.flag_error || right.flag_error)
+        return -1;
+
+    switch (m_Sym){
+    case SmallerThan:
+        return (left.upper < right.lower) ? 1 : (left.lower >= right.upper) ? 0 : -1;
+    case GreaterThan:
+        return (left.lower > right.upper) ? 1 : (left.upper <= right.lower) ? 0 : -1;
+    case SmallerThanEqual:
+        return (left.upper <= right.lower) ? 1 : (left.lower > right.upper) ? 0 : -1;
+    case GreaterThanEqual:
+        return (left.lower >= right.upper) ? 1 : (left.upper < right.lower) ? 0 : -1;
+    case ApproxEqual:
+        {
+            // bounds of |left - right|
+            double lower = left.lower - right.upper;
+            double upper = left.upper - right.lower;
+            double nearest = (lower <= 0 && upper >= 0) ? 0 : min(fabs(lower), fabs(upper));
+            double furthest = max(fabs(lower), fabs(upper));
+            double precision = m_Precision*m_Precision;
+            return (precision >= furthest*furthest) ? 1 : (precision < nearest*nearest) ? 0 : -1;
+        }
+    default:
+        assert (false && "Unknown inequality operator");
+        return -1;
+    }
+}
+
+void Inequality::refineBoundary(Region &region, const Region *mask)
+{
+    /*!	Refines the cells of the grid whose corners differ (see
+        boundaryCells), s_refinementChunk cells at a time so the sub-points
+        of few cells are held at once.*/
+
+    if (s_refinementDepth == 0 || !canBoundCells(region) || region.width() < 2 || region.height() < 2)
+        return;
+
+    region.setRefinement(1 << s_refinementDepth);
+    m_LeftExpression.prepareBatches();
+    m_RightExpression.prepareBatches();
+
+    vector<int> cells = boundaryCells(region, mask);
+    int cell_count = static_cast<int>(cells.size());
+    for (int first = 0; first < cell_count; first += s_refinementChunk){
+        if (*flag_Cancel)
+            return;
+        refineCells(region, cells, first, min(first + s_refinementChunk, cell_count));
+    }
+}
+
+vector<int> Inequality::boundaryCells(const Region &region, const Region *mask)
+{
+    /*!	Returns the index of each cell between point (column, row) and the
+        next points in x and y whose four corners are not all in or all out
+        of the region, in order. With a mask, a cell also needs a corner in
+        the mask, as the points outside of it were not compared.*/
+
+    vector<int> cells;
+    int words = region.wordsPerRow();
+    bool flag_mask = (mask != 0 && mask->sameGrid(region));
+
+    // the columns which have a next column
+    int last_bits = (region.width() - 1) % Region::s_wordBits;
+    int last_word = (region.width() - 2)/Region::s_wordBits;
+    RegionWord last_mask = (last_bits == 0) ? ~RegionWord(0) : (RegionWord(1) << last_bits) - 1;
+
+    for (int row = 0; row + 1 < region.height(); row++){
+        const RegionWord *rows[2] = { region.pointRow(row), region.pointRow(row + 1) };
+        const RegionWord *mask_rows[2] = { flag_mask ? mask->pointRow(row) : 0, flag_mask ? mask->pointRow(row + 1) : 0 };
+
+        for (int w = 0; w <= last_word; w++){
+            // corner (column + 1) of each column, shifted onto the column
+            RegionWord corners[2], next[2];
+            RegionWord active = 0;
+            for (int k = 0; k < 2; k++){
+                corners[k] = rows[k][w];
+                next[k] = (corners[k] >> 1) | ((w + 1 < words) ? rows[k][w+1] << (Region::s_wordBits - 1) : 0);
+                if (flag_mask)
+                    active |= mask_rows[k][w] | (mask_rows[k][w] >> 1) | ((w + 1 < words) ? mask_rows[k][w+1] << (Region::s_wordBits - 1) : 0);
+            }
+
+            RegionWord flips = (corners[0] ^ next[0]) | (corners[0] ^ corners[1]) | (corners[0] ^ next[1]);
+            if (flag_mask) { flips &= active; }
+            if (w == last_word) { flips &= last_mask; }
+
+            for (; flips != 0; flips &= flips - 1) { cells.push_back(row*region.width() + w*Region::s_wordBits + Region::lowestBit(flips)); }
         }
     }
-    return plot_points;
+    return cells;
 }
 
-vector<int> Inequality::getProblemElements_ResultsCombined()
+void Inequality::refineCells(Region &region, const vector<int> &cells, int first, int last)
 {
-    vector <int> combined_plot_problems;
-    vector <int> left_problem_points = m_LeftExpression.getProblemElements_Result();
-    vector <int> right_problem_points = m_RightExpression.getProblemElements_Result();
+    /*!	Refines cells first to last - 1 of cells. Each part of a cell whose
+        corners differ is split into quarters by comparing the middle of its
+        sides and its centre, as a batch for all of the parts; a quarter
+        whose corners agree takes their value, otherwise it is split again
+        until its sub-points are compared.
+
+        The sub-points of cell k are held on a grid of side refinement + 1,
+        to include the corners it shares with the next cells in x and y.*/
+
+    int refinement = region.refinement();
+    int side = refinement + 1;
+    int cell_count = last - first;
+    int x_index = m_Order.back();
+    int y_index = m_Order[m_Order.size()-2];
+
+    // compared value of each sub-point: -1 not compared, 0 or 1
+    vector<signed char> values(cell_count*side*side, -1);
+    vector<RegionWord> problems(cell_count, 0);
+    vector<RegionWord> filled(cell_count, 0);
+    vector<SubCell> parts;
+    for (int k = 0; k < cell_count; k++){
+        int column = cells[first + k] % region.width();
+        int row = cells[first + k]/region.width();
+        signed char *cell_values = &values[k*side*side];
+        cell_values[0] = region.contains(column, row);
+        cell_values[refinement] = region.contains(column + 1, row);
+        cell_values[refinement*side] = region.contains(column, row + 1);
+        cell_values[refinement*side + refinement] = region.contains(column + 1, row + 1);
+        problems[k] = region.isProblem(column, row) ? 1 : 0;
+
+        SubCell part = { k, 0, 0, refinement };
+        parts.push_back(part);
+    }
 
-    //combine both problem spaces
-    vector<int>::iterator it = left_problem_points.begin();
-    vector<int>::iterator jit = right_problem_points.begin();
+    // values of the variables at the gathered sub-points; the others have a single value
+    int variable_count = static_cast<int>(m_Variables.size());
+    vector<double> batch_values(variable_count*BATCH_SIZE);
+    vector<BatchSpan> spans(variable_count);
+    for (int j = 0; j < variable_count; j++){
+        BatchSpan span = { &batch_values[j*BATCH_SIZE], 1, 0 };
+        if (j != x_index && j != y_index){
+            batch_values[j*BATCH_SIZE] = m_Variables[j].value(0);
+            span.stride = 0;
+        }
+        spans[j] = span;
+    }
 
-    if( left_problem_points.empty() )
-        { combined_plot_problems = right_problem_points; }
-    else if ( right_problem_points.empty() )
-        { combined_plot_problems = left_problem_points; }
-    else {
-        while ( it != left_problem_points.end() &&
-                jit != right_problem_points.end() ){
-            if ( it == left_problem_points.end() ) {
-                    combined_plot_problems.push_back(*jit);
-                    jit++;
+    vector<int> pending;
+    while (!parts.empty()){
+        if (*flag_Cancel)
+            return;
+
+        // the middle of the sides and the centre of each part
+        pending.clear();
+        for (unsigned int p = 0; p < parts.size(); p++){
+            const SubCell &part = parts[p];
+            int half = part.size/2;
+            int points[5][2] = { { half, 0 }, { 0, half }, { half, half }, { part.size, half }, { half, part.size } };
+            for (int q = 0; q < 5; q++){
+                int sub = (part.j + points[q][1])*side + part.i + points[q][0];
+                signed char &value = values[part.cell*side*side + sub];
+                if (value != -1)
+                    continue;
+                value = -2;		// gathered
+                pending.push_back(part.cell*side*side + sub);
             }
-            else if ( jit == right_problem_points.end() ) {
-                    combined_plot_problems.push_back(*it);
-                    it++;
+        }
+
+        for (unsigned int start = 0; start < pending.size(); start += BATCH_SIZE){
+            int count = min(static_cast<int>(pending.size() - start), BATCH_SIZE);
+            for (int b = 0; b < count; b++){
+                int k = pending[start + b]/(side*side);
+                int sub = pending[start + b] % (side*side);
+                batch_values[x_index*BATCH_SIZE + b] = region.subX(cells[first + k] % region.width(), sub % side);
+                batch_values[y_index*BATCH_SIZE + b] = region.subY(cells[first + k]/region.width(), sub/side);
             }
-            else if (*it > *jit)	{
-                    combined_plot_problems.push_back(*jit);
-                    jit++;
+
+            bool flag_holds[BATCH_SIZE], flag_problems[BATCH_SIZE];
+            compareBatch(spans, count, flag_holds, flag_problems);
+            for (int b = 0; b < count; b++){
+                int k = pending[start + b]/(side*side);
+                int sub = pending[start + b] % (side*side);
+                values[pending[start + b]] = flag_holds[b];
+                if (flag_problems[b] && sub % side < refinement && sub/side < refinement)
+                    problems[k] |= RegionWord(1) << ((sub/side)*refinement + sub % side);
             }
-            else if (*it == *jit)	{
-                    combined_plot_problems.push_back(*jit);
-                    combined_plot_problems.push_back(*it);
-                    it++; jit++;
+        }
+
+        // quarters whose corners differ are split again
+        vector<SubCell> next_parts;
+        for (unsigned int p = 0; p < parts.size(); p++){
+            const SubCell &part = parts[p];
+            int half = part.size/2;
+            if (half == 1)
+                continue;		// every sub-point of the part is compared
+
+            const signed char *cell_values = &values[part.cell*side*side];
+            for (int q = 0; q < 4; q++){
+                int i = part.i + (q % 2)*half;
+                int j = part.j + (q/2)*half;
+                signed char corner = cell_values[j*side + i];
+                bool flag_uniform = (cell_values[j*side + i + half] == corner) && (cell_values[(j + half)*side + i] == corner)
+                        && (cell_values[(j + half)*side + i + half] == corner);
+
+                if (!flag_uniform){
+                    SubCell quarter = { part.cell, i, j, half };
+                    next_parts.push_back(quarter);
+                } else if (corner == 1){
+                    for (int dj = 0; dj < half; dj++){
+                        for (int di = 0; di < half; di++) { filled[part.cell] |= RegionWord(1) << ((j + dj)*refinement + i + di); }
+                    }
+                }
             }
-            else if (*it < *jit)	{
-                    combined_plot_problems.push_back(*it);
-                    it++;
+        }
+        parts.swap(next_parts);
+    }
+
+    // compared sub-points keep their value, the others that of their quarter
+    for (int k = 0; k < cell_count; k++){
+        RegionCell cell = { cells[first + k], filled[k], problems[k] };
+        const signed char *cell_values = &values[k*side*side];
+        for (int j = 0; j < refinement; j++){
+            for (int i = 0; i < refinement; i++){
+                signed char value = cell_values[j*side + i];
+                RegionWord bit = RegionWord(1) << (j*refinement + i);
+                if (value == 1) { cell.points |= bit; }
+                if (value == 0) { cell.points &= ~bit; }
             }
         }
+        region.addCell(cell);
+    }
+}
+
+bool Inequality::compare(double left, double right)
+{
+    switch (m_Sym){
+    case SmallerThan:
+        return left < right;
+    case GreaterThan:
+        return left > right;
+    case SmallerThanEqual:
+        return left <= right;
+    case GreaterThanEqual:
+        return left >= right;
+    case ApproxEqual:
+        return (m_Precision*m_Precision) >= (left - right)*(left - right);
+    default:
+        assert (false && "Unknown inequality operator");
+        return false;
+    }
+}
+
+float Inequality::fieldValue(double left, double right)
+{
+    /*!	A value which is negative where the comparison holds and positive
+        where it fails, and changes roughly linearly across the boundary:
+        the difference of the sides, or for ApproxEqual its distance from
+        the precision.*/
+
+    switch (m_Sym){
+    case SmallerThan:
+    case SmallerThanEqual:
+        return static_cast<float>(left - right);
+    case GreaterThan:
+    case GreaterThanEqual:
+        return static_cast<float>(right - left);
+    case ApproxEqual:
+        return static_cast<float>(fabs(left - right) - m_Precision);
+    default:
+        assert (false && "Unknown inequality operator");
+        return NAN;
     }
+}
 
-    return combined_plot_problems;
+vector<bool> Inequality::problemFlags(const vector<int> &problem_points, int size)
+{
+    vector<bool> flags(size, false);
+    for (unsigned int i = 0; i < problem_points.size(); i++) { flags[problem_points[i]] = true; }
+    return flags;
 }
 
 
@@ -208,7 +1127,7 @@ bool Inequality::variablesInit()
 
 }
 
-bool Inequality::variableIsValid (Variable & myVar){ return m_LeftExpression.variableNameIsValid(myVar); }
+bool Inequality::variableIsValid (const Variable &myVar){ return m_LeftExpression.variableNameIsValid(myVar); }
 
 string Inequality::getErrors()
 {
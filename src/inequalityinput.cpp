@@ -51,15 +51,13 @@ void InequalityInput::setNumber(int nNumber)
     ui->label_Index->setNum(nNumber+1);
 }
 
-void InequalityInput::setXYVariables(Variable mX, Variable mY)
+void InequalityInput::setXYVariables(const Variable &mX, const Variable &mY)
 {
     m_xVariable = mX;
     m_yVariable = mY;
 }
 
-void InequalityInput::setX(QVector<double> vX){ m_x = vX; }
-
-void InequalityInput::setY(QVector<double> vY){ m_y = vY; }
+void InequalityInput::setRegion(const Region &region){ m_region = region; }
 
 bool InequalityInput::createInequality()
 {
@@ -125,40 +123,21 @@ string InequalityInput::expressionToJSON()
 
 string InequalityInput::dataToJSON()
 {
-    vector<string> data_array;
-
-    // create point objects
-    for (int j = 0; j < m_x.size(); j++){
-        vector<string> point;
-        point.push_back( BlueJSON::jsonKeyValue("x", m_x[j]) );
-        point.push_back( BlueJSON::jsonKeyValue("y", m_y[j]) );
-        data_array.push_back( BlueJSON::jsonObject(point, Flat));
-    }
-
-    // create & return data array
-    string json = BlueJSON::jsonArray(data_array);
+    // the grid of the region is that of the variables of the case
+    vector<string> properties;
+    properties.push_back( BlueJSON::jsonKeyValue("width", m_region.width()) );
+    properties.push_back( BlueJSON::jsonKeyValue("height", m_region.height()) );
+    properties.push_back( BlueJSON::jsonKeyValue("points", m_region.pointsToRuns()) );
+    properties.push_back( BlueJSON::jsonKeyValue("problems", m_region.problemsToRuns()) );
+    properties.push_back( BlueJSON::jsonKeyValue("refinement", m_region.refinement()) );
+    properties.push_back( BlueJSON::jsonKeyValue("cells", m_region.cellsToString()) );
+
+    // create & return data object
+    string json = BlueJSON::jsonObject(properties, Flat);
     json = BlueJSON::jsonKeyValue("data", json);
     return json;
 }
 
-string InequalityInput::problemDataToJSON()
-{
-    vector<string> data_array;
-
-    // create point objects
-    for (int j = 0; j < m_x.size(); j++){
-        vector<string> point;
-        point.push_back( BlueJSON::jsonKeyValue("x", m_x_problem[j]) );
-        point.push_back( BlueJSON::jsonKeyValue("y", m_y_problem[j]) );
-        data_array.push_back( BlueJSON::jsonObject(point, Flat));
-    }
-
-    // create & return data array
-    string json = BlueJSON::jsonArray(data_array);
-    json = BlueJSON::jsonKeyValue("problem data", json);
-    return json;
-}
-
 void InequalityInput::fromJSON(string json)
 {
     BlueJSON parser = BlueJSON(json);
@@ -345,6 +324,9 @@ QwtSymbol::Style InequalityInput::getShape()
         // must send a signal to change line style
         return QwtSymbol::UserStyle;
         break;
+    case Filled:
+        return s_filledStyle;
+        break;
     }
     return QwtSymbol::NoSymbol;
 }
@@ -383,13 +365,32 @@ void InequalityInput::clearLineEditTextFormat(QLineEdit* lineEdit)
 //	Getters: Data
 //	--------------
 
-QVector<double> InequalityInput::getX(){ return m_x; }
+const Region &InequalityInput::getRegion(){ return m_region; }
 
-QVector<double> InequalityInput::getY(){ return m_y; }
+Inequality &InequalityInput::getInequality(){ return m_inequality; }
 
-QVector<double> InequalityInput::getXProblem(){ return m_x_problem; }
+double InequalityInput::getCost()
+{
+    // estimated time per point; the inequality is checked when evaluated
+    try{
+        return m_inequality.estimateCost();
+    }
+    catch(InputErrorCode){
+        return 0;
+    }
+}
 
-QVector<double> InequalityInput::getYProblem(){ return m_y_problem; }
+double InequalityInput::getSelectivity()
+{
+    // estimated part of the grid in which the inequality holds
+    m_inequality.setGrid(m_xVariable, m_yVariable);
+    try{
+        return m_inequality.estimateSelectivity();
+    }
+    catch(InputErrorCode){
+        return 1;
+    }
+}
 
 
 
@@ -489,7 +490,7 @@ void InequalityInput::clearFields()
 //	Core
 //	----
 
-bool InequalityInput::addVariable(Variable variable)
+bool InequalityInput::addVariable(const Variable &variable)
 {
     //	check variable unique
     if (!m_inequality.variableIsValid(variable))  {
@@ -500,11 +501,14 @@ bool InequalityInput::addVariable(Variable variable)
     return true;
 }
 
-bool InequalityInput::evaluate()
+bool InequalityInput::evaluate(const Region *mask)
 {
-    // do maths
+    // do maths, x turning fastest in the results; only at the points of mask if given
+    m_inequality.setGrid(m_xVariable, m_yVariable);
+    m_region = Region();
+
     try{
-        m_points = m_inequality.evaluate();
+        m_region = m_inequality.evaluate(mask);
     }
     catch(InputErrorCode e){ // catch errors that happen during evaluation
         switch(e){
@@ -524,44 +528,6 @@ bool InequalityInput::evaluate()
         }
     }
 
-    m_points_problem = m_inequality.getProblemElements_ResultsCombined();
-
-    // create QVectors (for plotting)
-    m_xVariable.resetPosition();		// reset iterators
-    m_yVariable.resetPosition();
-
-    m_x.clear();	// clear previous plotting vectors
-    m_y.clear();
-    m_x_problem.clear();
-    m_y_problem.clear();
-
-    bool flag_XBeforeY = m_inequality.getXBeforeY(m_xVariable, m_yVariable);
-
-    vector<int>::iterator it_ProblemSpace = m_points_problem.begin();
-    for(int i = 0; i < static_cast<int>(m_points.size()); i++){
-        if(!m_points_problem.empty() && i == *it_ProblemSpace){ 	// problem point - add to problem vectors
-            m_x_problem.push_back(m_xVariable.currentValue());
-            m_y_problem.push_back(m_yVariable.currentValue());
-            it_ProblemSpace++;
-        }
-        else if (m_points[i]) { 	// not a problem point - add to the normal graph vectors
-            m_x.push_back(m_xVariable.currentValue());
-            m_y.push_back(m_yVariable.currentValue());
-        }
-
-        //	TODO: XBeforeY more elegantly
-        if (flag_XBeforeY){ 		// accounts for the fact that evaluation happens in the order in which variables were *added*
-            if ((i+1) % m_yVariable.elements() == 0){
-                m_xVariable.nextPosition();
-            }
-            m_yVariable.nextPosition();
-        } else {
-            if ((i+1) % m_xVariable.elements() == 0){
-                m_yVariable.nextPosition();
-            }
-            m_xVariable.nextPosition();
-        }
-    }
     return true;
 }
 
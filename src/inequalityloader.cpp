@@ -28,6 +28,7 @@ static QString cropFileName(QString filename)
 InequalityLoader::InequalityLoader(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::InequalityLoader),
+    flag_combined(false),
     m_guiNumber(-1),
     flag_skip(false),
     flag_ok(true),
@@ -98,14 +99,16 @@ void InequalityLoader::loadCase(QString filename)
 }
 
 
-void InequalityLoader::setX(QVector<double> vector) { m_xResults_combination = vector; }
-
-void InequalityLoader::setY(QVector<double> vector) { m_yResults_combination = vector; }
+void InequalityLoader::setRegion(const Region &region)
+{
+    m_regionCombination = region;
+    flag_combined = true;
+}
 
 void InequalityLoader::clearCombinationResults()
 {
-    m_xResults_combination.clear();
-    m_yResults_combination.clear();
+    m_regionCombination = Region();
+    flag_combined = false;
 }
 
 void InequalityLoader::createDetailItem(int level, QString type, QString desc, QString data1, QString data2)
@@ -198,6 +201,12 @@ QwtSymbol::Style InequalityLoader::getShape()
     case Diamond:
         return QwtSymbol::Diamond;
         break;
+    case Dots:
+        return QwtSymbol::UserStyle;
+        break;
+    case Filled:
+        return s_filledStyle;
+        break;
     }
     return QwtSymbol::NoSymbol;
 }
@@ -206,28 +215,18 @@ QwtSymbol::Style InequalityLoader::getShape()
 //	Getters: Data
 //	--------------
 
-QVector<double> InequalityLoader::getX()
-{
-    return m_xResults_combination.empty() ? m_xResults[m_currentPlot] : m_xResults_combination;
-}
-
-QVector<double> InequalityLoader::getY()
+const Region &InequalityLoader::getRegion()
 {
-    return m_yResults_combination.empty() ? m_yResults[m_currentPlot] : m_yResults_combination;
+    return flag_combined ? m_regionCombination : m_regions[m_currentPlot];
 }
 
-QVector<double> InequalityLoader::getXProblem()
-{
-    //	not yet implemented
-    QVector <double> emptything = QVector<double>();
-    return emptything;
-}
+double InequalityLoader::getCost() { return 0; }	// the results are loaded, not evaluated
 
-QVector<double> InequalityLoader::getYProblem()
+double InequalityLoader::getSelectivity()
 {
-    //	not yet implemented
-    QVector <double> emptything = QVector<double>();
-    return emptything;
+    const Region &region = getRegion();
+    double grid_points = static_cast<double>(region.width())*region.height();
+    return (grid_points > 0) ? region.count()/grid_points : 0;
 }
 
 QString InequalityLoader::getFile() { return m_file.fileName(); }
@@ -267,7 +266,7 @@ void InequalityLoader::parseFile(QString json)
     flag_cumulOK &=flag_ok;
 
     m_variables = QString::fromStdString(token);
-    formatVariables(m_variables);
+    formatVariables(m_variables, true);
 
 
     //	main case plots
@@ -317,27 +316,73 @@ void InequalityLoader::parseFile(QString json)
 void InequalityLoader::parsePlotData(QString json)
 {
     string token;
-    double point;
-    QVector<double> x_vector, y_vector;
+    Region region(m_xVariable, m_yVariable);
     BlueJSON parser = BlueJSON(json.toStdString());
 
-    while ( parser.getNextKeyValue("x", token) ){
-        flag_ok &= parser.getDoubleToken(point);
-        x_vector.push_back(point);
-
-        flag_ok &= parser.getNextKeyValue("y", token);
-        flag_ok &= parser.getDoubleToken(point);
-        y_vector.push_back(point);
-    }
-
-    checkOK("Data | problem parsing co-ordinate [" + QString::number(x_vector.count()) + "]");
+    if (parser.getNextKeyValue("points", token)){
+        //	region: runs of the points of the grid
+        int width = 0, height = 0;
+        string problems;
+        BlueJSON size_parser = BlueJSON(json.toStdString());
+        BlueJSON problem_parser = BlueJSON(json.toStdString());
+
+        flag_ok &= size_parser.getNextKeyValue("width", token);
+        flag_ok &= size_parser.getIntToken(width);
+        flag_ok &= size_parser.getNextKeyValue("height", token);
+        flag_ok &= size_parser.getIntToken(height);
+        checkOK("Data | problem parsing the size of the grid");
+
+        if (width != region.width() || height != region.height()){ flag_ok = false; }
+        checkOK("Data | the grid does not match the horizontal and vertical variables\n");
+
+        flag_ok &= parser.getStringToken(token);
+        flag_ok &= region.pointsFromRuns(token);
+        flag_ok &= problem_parser.getNextKeyValue("problems", problems);
+        flag_ok &= problem_parser.getStringToken(problems);
+        flag_ok &= region.problemsFromRuns(problems);
+        checkOK("Data | problem parsing the points of the grid");
+
+        //	refined cells, if the plot was saved with them
+        int refinement = 1;
+        string cells;
+        BlueJSON refinement_parser = BlueJSON(json.toStdString());
+        if (refinement_parser.getNextKeyValue("refinement", token)){
+            flag_ok &= refinement_parser.getIntToken(refinement);
+            flag_ok &= (refinement >= 1 && refinement <= Region::s_maxRefinement && (refinement & (refinement - 1)) == 0);
+            checkOK("Data | problem parsing the refinement of the grid");
+        }
+        if (flag_ok && refinement > 1){
+            region.setRefinement(refinement);
+            flag_ok &= refinement_parser.getNextKeyValue("cells", cells);
+            flag_ok &= refinement_parser.getStringToken(cells);
+            flag_ok &= region.cellsFromString(cells);
+            checkOK("Data | problem parsing the refined cells of the grid");
+        }
 
-    if (x_vector.size() != y_vector.size()){ flag_ok = false; }
+        // problem points are not plotted as points (see Inequality::evaluate)
+        region.excludeProblems();
+    } else {
+        //	points: co-ordinates, placed on the nearest point of the grid
+        double x, y;
+        int count = 0;
+        BlueJSON point_parser = BlueJSON(json.toStdString());
+
+        while ( point_parser.getNextKeyValue("x", token) ){
+            flag_ok &= point_parser.getDoubleToken(x);
+            flag_ok &= point_parser.getNextKeyValue("y", token);
+            flag_ok &= point_parser.getDoubleToken(y);
+
+            int column = Region::nearestIndex(m_xVariable, x);
+            int row = Region::nearestIndex(m_yVariable, y);
+            if (column >= 0 && row >= 0) { region.setPoint(column, row, true); }
+            else { flag_ok = false; }
+            count++;
+        }
 
-    checkOK("Data | data set does not have the same amount of x-values as y-values\n");
+        checkOK("Data | problem parsing co-ordinate [" + QString::number(count) + "]");
+    }
 
-    m_xResults << x_vector;
-    m_yResults << y_vector;
+    m_regions << region;
 }
 
 void InequalityLoader::parseProblem(QString problem)
@@ -350,8 +395,12 @@ void InequalityLoader::formatPlot()
     createDetailItem(m_detailLevel, "Plot", "", "", "");
 }
 
-void InequalityLoader::formatVariables(QString json)
+void InequalityLoader::formatVariables(QString json, bool flag_grid)
 {
+    /*!	Lists the variables in the details. If flag_grid is set, these are
+        the variables of the case and the plots lie on the grid of its
+        horizontal and vertical variables.*/
+
     string name, units, axis, token;
     int steps;
     double min, max;
@@ -372,6 +421,9 @@ void InequalityLoader::formatVariables(QString json)
 
         checkOK("Variable | Problem parsing [" + QString::fromStdString(name) + "]");
 
+        if (flag_grid && axis == "horizontal") { m_xVariable = Variable(name, min, max, steps); }
+        if (flag_grid && axis == "vertical") { m_yVariable = Variable(name, min, max, steps); }
+
         stringstream buffer;
         buffer << "linear [" << min << ";" << max << "]"
                   " in " << steps << " steps";
@@ -462,20 +514,17 @@ QString InequalityLoader::expressionToJSON()
 
 QString InequalityLoader::dataToJSON()
 {
-    QVector<double> x= getX();
-    QVector<double> y= getY();
-    vector<string> data_array;
-
-    // create point objects
-    for (int i = 0; i < x.size(); i++){
-        vector<string> point;
-        point.push_back( BlueJSON::jsonKeyValue("x", x[i]) );
-        point.push_back( BlueJSON::jsonKeyValue("y", y[i]) );
-        data_array.push_back( BlueJSON::jsonObject(point, Flat));
-    }
-
-    // create & return data array
-    string json = BlueJSON::jsonArray(data_array);
+    const Region &region = getRegion();
+    vector<string> properties;
+    properties.push_back( BlueJSON::jsonKeyValue("width", region.width()) );
+    properties.push_back( BlueJSON::jsonKeyValue("height", region.height()) );
+    properties.push_back( BlueJSON::jsonKeyValue("points", region.pointsToRuns()) );
+    properties.push_back( BlueJSON::jsonKeyValue("problems", region.problemsToRuns()) );
+    properties.push_back( BlueJSON::jsonKeyValue("refinement", region.refinement()) );
+    properties.push_back( BlueJSON::jsonKeyValue("cells", region.cellsToString()) );
+
+    // create & return data object
+    string json = BlueJSON::jsonObject(properties, Flat);
     json = BlueJSON::jsonKeyValue("data", json);
     return QString::fromStdString(json);
 }
@@ -519,7 +568,7 @@ void InequalityLoader::setComboBoxPlot()
 {
     if (ui->comboBox_Plot->count() == 0){
         QStringList combo_data;
-        for (int i = 0; i < m_xResults.count(); i++){
+        for (int i = 0; i < m_regions.count(); i++){
             stringstream buffer;
             if (i < m_dropDownList.count()){
                 buffer << m_dropDownList[i].toStdString();
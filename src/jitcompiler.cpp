@@ -0,0 +1,551 @@
+///	Includes
+///	=========
+
+    #include"include/jitcompiler.h"
+
+#ifdef JITCOMPILER_NATIVE
+    #include<sys/mman.h>
+    #include<unistd.h>
+    #include<pthread.h>
+#endif
+
+
+///	Static Variables
+///	=================
+
+#ifdef JITCOMPILER_NATIVE
+JitMode JitCompiler::s_mode = JitOn;
+static pthread_mutex_t s_cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+#else
+JitMode JitCompiler::s_mode = JitOff;
+#endif
+
+map<string, JitProgram*> JitCompiler::s_cache;
+
+
+#ifdef JITCOMPILER_NATIVE
+
+///	Code Generation
+///	================
+
+//	Registers
+//	----------
+//	xmm0  - xmm11	values of the segment
+//	xmm12 - xmm13	operands loaded from the batch registers
+//	xmm14			scratch
+//	xmm15			sum of (v - v) over all divisions and square roots, NaN if any was non-finite
+//	rdi, rsi, rdx	registers, variables, count
+//	rcx				index of the current point
+//	r8				count rounded down to pairs of points
+
+static const int s_valueRegisters	= 12;
+static const int s_operandLhs		= 12;
+static const int s_operandRhs		= 13;
+static const int s_scratch			= 14;
+static const int s_nonFinite		= 15;
+
+static const int s_rowBytes = BATCH_SIZE * sizeof(double);
+
+enum SseOpcode
+{
+    SseLoad		= 0x10,
+    SseStore	= 0x11,
+    SseUnpackHi	= 0x15,
+    SseMove		= 0x28,
+    SseCompare	= 0x2E,
+    SseSquareRoot = 0x51,
+    SseXor		= 0x57,
+    SseAdd		= 0x58,
+    SseMultiply	= 0x59,
+    SseSubtract	= 0x5C,
+    SseDivide	= 0x5E,
+};
+
+class JitEmitter
+{
+public:
+    JitEmitter(): m_Packed(true) {}
+
+    vector<unsigned char> m_Code;
+    vector<double> m_Pool;				// pairs of doubles, 16 byte aligned
+    vector<pair<int, int> > m_PoolFixups;	// code offset of a displacement, pool entry
+    bool m_Packed;						// two points at a time, or the single last point
+
+    void byte(unsigned char b) { m_Code.push_back(b); }
+
+    void dword(int value)
+    {
+        for (int i = 0; i < 4; i++) { byte(static_cast<unsigned char>((value >> (8*i)) & 0xFF)); }
+    }
+
+    void patch(int offset, int value)
+    {
+        for (int i = 0; i < 4; i++) { m_Code[offset + i] = static_cast<unsigned char>((value >> (8*i)) & 0xFF); }
+    }
+
+    int poolEntry(double value)
+    {
+        for (int i = 0; i < static_cast<int>(m_Pool.size()); i += 2){
+            if (memcmp(&m_Pool[i], &value, sizeof(double)) == 0)
+                return i/2;
+        }
+        m_Pool.push_back(value);
+        m_Pool.push_back(value);
+        return static_cast<int>(m_Pool.size())/2 - 1;
+    }
+
+    // sse instruction on registers; arithmetic is packed or scalar by mode
+    void sse(unsigned char opcode, int reg, int rm, bool flag_arithmetic = true)
+    {
+        byte((flag_arithmetic && !m_Packed) ? 0xF2 : 0x66);
+        if (reg >= 8 || rm >= 8) { byte(0x40 | (reg >= 8 ? 4 : 0) | (rm >= 8 ? 1 : 0)); }
+        byte(0x0F);
+        byte(opcode);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // load or store of [base + rcx*8 + displacement]
+    void sseIndexed(unsigned char opcode, int reg, int base, int displacement)
+    {
+        byte(m_Packed ? 0x66 : 0xF2);
+        if (reg >= 8) { byte(0x44); }
+        byte(0x0F);
+        byte(opcode);
+        byte(0x84 | ((reg & 7) << 3));
+        byte(0xC8 | base);
+        dword(displacement);
+    }
+
+    // packed instruction on a pool entry, [rip + displacement]
+    void ssePool(unsigned char opcode, int reg, int entry)
+    {
+        byte(0x66);
+        if (reg >= 8) { byte(0x44); }
+        byte(0x0F);
+        byte(opcode);
+        byte(0x05 | ((reg & 7) << 3));
+        m_PoolFixups.push_back(make_pair(static_cast<int>(m_Code.size()), entry));
+        dword(0);
+    }
+
+    void loadRow(int reg, int row)		{ sseIndexed(SseLoad, reg, 7, row*s_rowBytes); }	// rdi
+    void storeRow(int reg, int row)		{ sseIndexed(SseStore, reg, 7, row*s_rowBytes); }
+    void loadConstant(int reg, double value) { ssePool(SseMove, reg, poolEntry(value)); }
+
+    void loadVariable(int reg, int slot)
+    {
+        // mov rax, [rsi + slot*8]
+        byte(0x48); byte(0x8B); byte(0x86); dword(slot*static_cast<int>(sizeof(double*)));
+        sseIndexed(SseLoad, reg, 0, 0);	// rax
+    }
+
+    void move(int dest, int src)
+    {
+        if (dest != src) { sse(SseMove, dest, src, false); }
+    }
+
+    int jumpIfNotBelow()	{ byte(0x0F); byte(0x8D); dword(0); return static_cast<int>(m_Code.size()) - 4; }
+    int jump()				{ byte(0xE9); dword(0); return static_cast<int>(m_Code.size()) - 4; }
+    void target(int fixup)	{ patch(fixup, static_cast<int>(m_Code.size()) - (fixup + 4)); }
+};
+
+
+//	Segments
+//	---------
+
+static bool isArithmetic(OpCode code)
+{
+    switch(code){
+    case OpConstant:
+    case OpVariable:
+    case OpNegate:
+    case OpAdd:
+    case OpSubtract:
+    case OpMultiply:
+    case OpDivide:
+    case OpSquareRoot:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void emitBody(JitEmitter &emitter, const vector<Instruction> &program, int first, int last,
+                     const vector<bool> &flag_store, const vector<bool> &flag_hoisted)
+{
+    /*!	Emits the instructions [first, last) for the point(s) at rcx.
+        Values keep their register until their last use in the segment.
+        Hoisted instructions are not emitted; like the values of earlier
+        segments, they are read from their batch registers.*/
+
+    // operands held in a value register of the segment
+    vector<bool> flag_held(last, false);
+    for (int i = first; i < last; i++) { flag_held[i] = !flag_hoisted[i]; }
+
+    vector<int> last_use(last, UninitializedCounter);
+    for (int i = first; i < last; i++){
+        const Instruction &instruction = program[i];
+        if (flag_hoisted[i])
+            continue;
+        if (instruction.lhs >= 0 && flag_held[instruction.lhs]) { last_use[instruction.lhs] = i; }
+        if (instruction.rhs >= 0 && flag_held[instruction.rhs]) { last_use[instruction.rhs] = i; }
+    }
+
+    vector<int> reg_of(last, UninitializedCounter);
+    vector<bool> flag_free(s_valueRegisters, true);
+
+    for (int i = first; i < last; i++){
+        const Instruction &instruction = program[i];
+        if (flag_hoisted[i])
+            continue;
+
+        // operands
+        int lhs = UninitializedCounter;
+        int rhs = UninitializedCounter;
+        if (instruction.lhs >= 0){
+            lhs = flag_held[instruction.lhs] ? reg_of[instruction.lhs] : s_operandLhs;
+            if (!flag_held[instruction.lhs]) { emitter.loadRow(lhs, instruction.lhs); }
+        }
+        if (instruction.rhs >= 0){
+            rhs = flag_held[instruction.rhs] ? reg_of[instruction.rhs] : s_operandRhs;
+            if (!flag_held[instruction.rhs]) { emitter.loadRow(rhs, instruction.rhs); }
+        }
+
+        // free operands at their last use; the result may reuse them
+        bool flag_lhs_dies = instruction.lhs >= 0 && flag_held[instruction.lhs] && last_use[instruction.lhs] == i;
+        if (flag_lhs_dies) { flag_free[lhs] = true; }
+        if (instruction.rhs >= 0 && flag_held[instruction.rhs] && last_use[instruction.rhs] == i) { flag_free[rhs] = true; }
+
+        int dest = UninitializedCounter;
+        if (flag_lhs_dies) {
+            dest = lhs;
+        } else {
+            for (int r = 0; r < s_valueRegisters; r++){
+                if (flag_free[r]) { dest = r; break; }
+            }
+        }
+        assert(dest >= 0 && "emitBody: Out of registers");
+        flag_free[dest] = false;
+        reg_of[i] = dest;
+
+        unsigned char opcode = 0;
+        bool flag_commutative = false;
+        switch(instruction.code){
+        case OpConstant:	emitter.loadConstant(dest, instruction.value);		break;
+        case OpVariable:	emitter.loadVariable(dest, instruction.slot);		break;
+        case OpNegate:
+            emitter.move(dest, lhs);
+            emitter.ssePool(SseXor, dest, emitter.poolEntry(-0.0));
+            break;
+        case OpSquareRoot:	emitter.sse(SseSquareRoot, dest, lhs);				break;
+        case OpAdd:			opcode = SseAdd;		flag_commutative = true;	break;
+        case OpMultiply:	opcode = SseMultiply;	flag_commutative = true;	break;
+        case OpSubtract:	opcode = SseSubtract;	break;
+        case OpDivide:		opcode = SseDivide;		break;
+        default:
+            assert(false && "emitBody: Instruction is not arithmetic");
+            break;
+        }
+
+        if (opcode != 0){
+            if (dest == lhs) {
+                emitter.sse(opcode, dest, rhs);
+            } else if (dest == rhs && flag_commutative) {
+                emitter.sse(opcode, dest, lhs);
+            } else if (dest == rhs) {
+                emitter.move(s_scratch, lhs);
+                emitter.sse(opcode, s_scratch, rhs);
+                emitter.move(dest, s_scratch);
+            } else {
+                emitter.move(dest, lhs);
+                emitter.sse(opcode, dest, rhs);
+            }
+        }
+
+        if (instruction.code == OpDivide || instruction.code == OpSquareRoot){
+            emitter.move(s_scratch, dest);
+            emitter.sse(SseSubtract, s_scratch, dest);
+            emitter.sse(SseAdd, s_nonFinite, s_scratch);
+        }
+
+        if (flag_store[i]) { emitter.storeRow(dest, i); }
+        if (last_use[i] == UninitializedCounter) { flag_free[dest] = true; }
+    }
+}
+
+static void emitSegment(JitEmitter &emitter, const vector<Instruction> &program, int first, int last,
+                        const vector<bool> &flag_store, const vector<bool> &flag_hoisted)
+{
+    emitter.byte(0x48); emitter.byte(0x63); emitter.byte(0xD2);	// movsxd rdx, edx
+    emitter.sse(SseXor, s_nonFinite, s_nonFinite, false);		// xorpd xmm15, xmm15
+    emitter.byte(0x31); emitter.byte(0xC9);						// xor ecx, ecx
+    emitter.byte(0x49); emitter.byte(0x89); emitter.byte(0xD0);	// mov r8, rdx
+    emitter.byte(0x49); emitter.byte(0x83); emitter.byte(0xE0); emitter.byte(0xFE);	// and r8, -2
+
+    // pairs of points
+    int loop = static_cast<int>(emitter.m_Code.size());
+    emitter.byte(0x4C); emitter.byte(0x39); emitter.byte(0xC1);	// cmp rcx, r8
+    int to_tail = emitter.jumpIfNotBelow();
+    emitter.m_Packed = true;
+    emitBody(emitter, program, first, last, flag_store, flag_hoisted);
+    emitter.byte(0x48); emitter.byte(0x83); emitter.byte(0xC1); emitter.byte(0x02);	// add rcx, 2
+    int to_loop = emitter.jump();
+    emitter.patch(to_loop, loop - (to_loop + 4));
+
+    // last point of an odd count
+    emitter.target(to_tail);
+    emitter.byte(0x48); emitter.byte(0x39); emitter.byte(0xD1);	// cmp rcx, rdx
+    int to_done = emitter.jumpIfNotBelow();
+    emitter.m_Packed = false;
+    emitBody(emitter, program, first, last, flag_store, flag_hoisted);
+    emitter.m_Packed = true;
+
+    // return (xmm15 is NaN in either lane)
+    emitter.target(to_done);
+    emitter.move(s_scratch, s_nonFinite);
+    emitter.sse(SseUnpackHi, s_scratch, s_scratch, false);
+    emitter.m_Packed = false;
+    emitter.sse(SseAdd, s_nonFinite, s_scratch);
+    emitter.m_Packed = true;
+    emitter.byte(0x31); emitter.byte(0xC0);						// xor eax, eax
+    emitter.sse(SseCompare, s_nonFinite, s_nonFinite, false);	// ucomisd xmm15, xmm15
+    emitter.byte(0x0F); emitter.byte(0x9A); emitter.byte(0xC0);	// setp al
+    emitter.byte(0xC3);											// ret
+}
+
+static vector<JitStep> planSteps(const vector<Instruction> &program, const vector<bool> &flag_hoisted)
+{
+    /*!	Splits the program into segments of arithmetic instructions and
+        single interpreted instructions. A segment is cut where the values
+        still needed would not fit in the value registers. Hoisted
+        instructions are passed over by the segments, and are single steps
+        elsewhere, whose errors the Expression applies.*/
+
+    int size = static_cast<int>(program.size());
+    vector<int> last_use(size, UninitializedCounter);
+    for (int i = 0; i < size; i++){
+        if (flag_hoisted[i])
+            continue;
+        if (program[i].lhs >= 0) { last_use[program[i].lhs] = i; }
+        if (program[i].rhs >= 0) { last_use[program[i].rhs] = i; }
+    }
+
+    vector<JitStep> steps;
+    int i = 0;
+    while (i < size){
+        JitStep step = { i, i + 1, 0 };
+        if (flag_hoisted[i] || !isArithmetic(program[i].code)){
+            steps.push_back(step);
+            i++;
+            continue;
+        }
+
+        // extend the segment while the live values fit
+        int end = i;
+        while (end < size && (flag_hoisted[end] || isArithmetic(program[end].code))){
+            int live = 0;
+            for (int j = i; j < end; j++){
+                if (!flag_hoisted[j] && last_use[j] > end) { live++; }
+            }
+            if (live + 1 > s_valueRegisters)
+                break;
+            end++;
+        }
+
+        // the segment ends on an instruction it computes
+        while (flag_hoisted[end-1]) { end--; }
+        step.last = end;
+        steps.push_back(step);
+        i = end;
+    }
+    return steps;
+}
+
+static vector<bool> hoistedInstructions(const vector<Instruction> &program, int inner_slot)
+{
+    // the instructions which do not depend on the variable of inner_slot
+    int size = static_cast<int>(program.size());
+    vector<bool> flag_hoisted(size, true);
+    for (int i = 0; i < size; i++){
+        const Instruction &instruction = program[i];
+        bool flag_inner = (instruction.code == OpVariable && instruction.slot == inner_slot);
+        if (instruction.lhs >= 0 && !flag_hoisted[instruction.lhs]) { flag_inner = true; }
+        if (instruction.rhs >= 0 && !flag_hoisted[instruction.rhs]) { flag_inner = true; }
+        flag_hoisted[i] = !flag_inner;
+    }
+    return flag_hoisted;
+}
+
+static vector<JitStep> emitPlan(JitEmitter &emitter, const vector<Instruction> &program, const vector<bool> &flag_hoisted,
+                                vector<int> &offsets)
+{
+    /*!	Plans the steps of the program and emits its segments, writing the
+        code offset of each segment to offsets.*/
+
+    int size = static_cast<int>(program.size());
+    vector<JitStep> steps = planSteps(program, flag_hoisted);
+
+    // instruction -> step
+    vector<int> step_of(size);
+    for (int s = 0; s < static_cast<int>(steps.size()); s++){
+        for (int i = steps[s].first; i < steps[s].last; i++) { step_of[i] = s; }
+    }
+
+    // values used outside of their segment, and the result, are stored
+    vector<bool> flag_store(size, false);
+    flag_store[size-1] = true;
+    for (int i = 0; i < size; i++){
+        if (program[i].lhs >= 0 && step_of[program[i].lhs] != step_of[i]) { flag_store[program[i].lhs] = true; }
+        if (program[i].rhs >= 0 && step_of[program[i].rhs] != step_of[i]) { flag_store[program[i].rhs] = true; }
+    }
+
+    offsets.assign(steps.size(), UninitializedCounter);
+    for (int s = 0; s < static_cast<int>(steps.size()); s++){
+        if (flag_hoisted[steps[s].first] || !isArithmetic(program[steps[s].first].code))
+            continue;
+        while (emitter.m_Code.size() % 16 != 0) { emitter.byte(0x90); }	// nop
+        offsets[s] = static_cast<int>(emitter.m_Code.size());
+        emitSegment(emitter, program, steps[s].first, steps[s].last, flag_store, flag_hoisted);
+    }
+    return steps;
+}
+
+#endif // JITCOMPILER_NATIVE
+
+
+///	Public Functions
+///	=================
+
+//	Settings
+//	---------
+
+void JitCompiler::setMode(JitMode mode) { s_mode = isSupported() ? mode : JitOff; }
+
+JitMode JitCompiler::mode() { return s_mode; }
+
+string JitCompiler::modeName(JitMode mode)
+{
+    switch(mode){
+    case JitOff:		return "off";
+    case JitOn:			return "on";
+    case JitValidate:	return "validate";
+    }
+    return "";
+}
+
+bool JitCompiler::modeFromName(string name, JitMode &mode)
+{
+    for (int i = JitOff; i <= JitValidate; i++){
+        if (name == modeName(static_cast<JitMode>(i))){
+            mode = static_cast<JitMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JitCompiler::isSupported()
+{
+#ifdef JITCOMPILER_NATIVE
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+//	Compilation
+//	------------
+
+const JitProgram *JitCompiler::compile(const string &key, const vector<Instruction> &program, int inner_slot)
+{
+    /*!	Returns the compiled program for key, compiling it on first use.
+        Returns 0 if the program should be interpreted. The key must
+        identify inner_slot, the slot of the innermost variable of a grid.*/
+
+    if (s_mode == JitOff || program.empty())
+        return 0;
+
+#ifdef JITCOMPILER_NATIVE
+    pthread_mutex_lock(&s_cacheMutex);
+
+    JitProgram *compiled = 0;
+    map<string, JitProgram*>::iterator it = s_cache.find(key);
+    if (it != s_cache.end()) {
+        compiled = it->second;
+    } else if (s_cache.size() < JIT_CACHE_SIZE) {
+        compiled = compileProgram(program, inner_slot);
+        s_cache[key] = compiled;	// failures are cached too
+    }
+
+    pthread_mutex_unlock(&s_cacheMutex);
+    return compiled;
+#else
+    (void)key;
+    (void)inner_slot;
+    return 0;
+#endif
+}
+
+
+///	Private Functions
+///	==================
+
+JitProgram *JitCompiler::compileProgram(const vector<Instruction> &program, int inner_slot)
+{
+#ifdef JITCOMPILER_NATIVE
+    int size = static_cast<int>(program.size());
+
+    // emit the segments of both plans into one block of code, followed by the constant pool
+    JitEmitter emitter;
+    vector<int> offsets, hoisted_offsets;
+    vector<JitStep> steps = emitPlan(emitter, program, vector<bool>(size, false), offsets);
+    vector<JitStep> hoisted_steps;
+    if (inner_slot > 0)
+        hoisted_steps = emitPlan(emitter, program, hoistedInstructions(program, inner_slot), hoisted_offsets);
+    while (emitter.m_Code.size() % 16 != 0) { emitter.byte(0x90); }
+
+    int pool_offset = static_cast<int>(emitter.m_Code.size());
+    for (int f = 0; f < static_cast<int>(emitter.m_PoolFixups.size()); f++){
+        int fixup = emitter.m_PoolFixups[f].first;
+        int entry = pool_offset + emitter.m_PoolFixups[f].second * 2 * static_cast<int>(sizeof(double));
+        emitter.patch(fixup, entry - (fixup + 4));
+    }
+
+    size_t pool_size = emitter.m_Pool.size() * sizeof(double);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t code_size = ((pool_offset + pool_size + page - 1) / page) * page;
+
+    void *code = mmap(0, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+        return 0;
+
+    unsigned char *bytes = static_cast<unsigned char*>(code);
+    memcpy(bytes, emitter.m_Code.data(), emitter.m_Code.size());
+    if (pool_size > 0) { memcpy(bytes + pool_offset, emitter.m_Pool.data(), pool_size); }
+
+    if (mprotect(code, code_size, PROT_READ | PROT_EXEC) != 0){
+        munmap(code, code_size);
+        return 0;
+    }
+
+    JitProgram *compiled = new JitProgram;
+    compiled->code = code;
+    compiled->code_size = code_size;
+    compiled->steps = steps;
+    for (int s = 0; s < static_cast<int>(steps.size()); s++){
+        if (offsets[s] != UninitializedCounter)
+            compiled->steps[s].segment = reinterpret_cast<JitSegment>(bytes + offsets[s]);
+    }
+    compiled->hoisted_steps = hoisted_steps;
+    for (int s = 0; s < static_cast<int>(hoisted_steps.size()); s++){
+        if (hoisted_offsets[s] != UninitializedCounter)
+            compiled->hoisted_steps[s].segment = reinterpret_cast<JitSegment>(bytes + hoisted_offsets[s]);
+    }
+    return compiled;
+#else
+    (void)program;
+    (void)inner_slot;
+    return 0;
+#endif
+}
@@ -2,9 +2,59 @@
 #include <iostream>
 #include <stdlib.h>
 #include "include/plotus.h"
+#include "include/jitcompiler.h"
+
+static bool optionValue(const std::string &option, int argc, char *argv[], int &i, std::string &value)
+{
+    /*!	Matches --option=<value> and --option <value> at argv[i].*/
+
+    std::string arg = argv[i];
+    if (arg.compare(0, option.size() + 1, option + "=") == 0){
+        value = arg.substr(option.size() + 1);
+        return true;
+    }
+    if (arg == option && i + 1 < argc){
+        value = argv[++i];
+        return true;
+    }
+    return false;
+}
+
+static void parseOptions(int argc, char *argv[])
+{
+    /*!	Handles the evaluation options, which are mainly for benchmarking:
+        --isa overrides the instruction set detected for the math kernels,
+        --jit selects native code, the interpreter, or both to validate.*/
+
+    for (int i = 1; i < argc; i++){
+        std::string name;
+
+        if (optionValue("--isa", argc, argv, i, name)){
+            KernelIsa isa;
+            if (!MathKernels::isaFromName(name, isa)){
+                std::cerr << "plotus: unknown instruction set '" << name << "' (expected sse2, avx2 or avx512)" << std::endl;
+            } else if (!MathKernels::setIsa(isa)){
+                std::cerr << "plotus: this CPU does not support " << name << std::endl;
+            }
+            std::cout << "plotus: using " << MathKernels::isaName(MathKernels::isa()) << " evaluation kernels" << std::endl;
+        }
+        else if (optionValue("--jit", argc, argv, i, name)){
+            JitMode mode;
+            if (!JitCompiler::modeFromName(name, mode)){
+                std::cerr << "plotus: unknown jit mode '" << name << "' (expected off, on or validate)" << std::endl;
+            } else if (mode != JitOff && !JitCompiler::isSupported()){
+                std::cerr << "plotus: native code is not supported on this platform" << std::endl;
+            } else {
+                JitCompiler::setMode(mode);
+            }
+            std::cout << "plotus: jit " << JitCompiler::modeName(JitCompiler::mode()) << std::endl;
+        }
+    }
+}
 
 int main (int argc, char *argv[]){
     std::cout.precision(9);
+    parseOptions(argc, argv);
     QApplication a(argc, argv);
 	Plotus w;
 	w.show();
@@ -0,0 +1,754 @@
+///	Includes
+///	=========
+
+    #include"include/mathkernels.h"
+
+/*! The selects in the kernels are only if-converted, and the loops vectorized,
+    when comparisons may be treated as non-trapping. */
+#ifdef __GNUC__
+#pragma GCC optimize ("no-trapping-math")
+#endif
+
+
+///	Constants
+///	==========
+
+static const double s_round		= 6755399441055744.0;		// 1.5 * 2^52, rounds to the nearest integer when added
+static const double s_twoPow52	= 4503599627370496.0;		// 2^52
+static const double s_twoPow54	= 18014398509481984.0;		// 2^54
+static const double s_twoPow28	= 268435456.0;				// 2^28
+static const double s_minNormal	= 2.2250738585072014e-308;
+
+static const double s_log2e		= 1.44269504088896338700e+00;
+static const double s_ln2		= 6.93147180559945286227e-01;
+static const double s_ln2Hi		= 6.93147180369123816490e-01;
+static const double s_ln2Lo		= 1.90821492927058770002e-10;
+static const double s_invLn10	= 4.34294481903251816668e-01;
+static const double s_sqrt2		= 1.41421356237309514547e+00;
+
+static const double s_pi		= 3.14159265358979311600e+00;
+static const double s_twoOverPi	= 6.36619772367581382433e-01;
+static const double s_pio2Hi	= 1.57079632679489655800e+00;
+static const double s_pio2Lo	= 6.12323399573676603587e-17;
+static const double s_pio2_1	= 1.57079632673412561417e+00;	// first 33 bits of pi/2
+static const double s_pio2_2	= 6.07710050630396597660e-11;	// next 33 bits of pi/2
+static const double s_pio2_3	= 2.02226624871116645580e-21;	// next 33 bits of pi/2
+static const double s_pio2_3t	= 8.47842766036889956997e-32;	// pi/2 - (s_pio2_1 + s_pio2_2 + s_pio2_3)
+
+static const double s_expMax	= 7.09782712893383973096e+02;	// largest x for which exp(x) is finite
+static const double s_expMin	= -7.45133219101941108420e+02;	// smallest x for which exp(x) is not 0
+static const double s_trigLimit	= 1e5;							// largest |x| reduced by the fast trig kernels
+static const double s_hyperLimit = 709;							// largest |x| of the fast sinh and cosh kernels
+
+
+///	Scalar Kernels
+///	===============
+//	Branch-free building blocks; loops over these are vectorized by the compiler.
+
+static inline uint64_t toBits(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static inline double fromBits(uint64_t bits)
+{
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static inline double kernelExp(double x)
+{
+    // exp(x) = 2^k * exp(r), |r| <= ln2/2
+    double xc = x < s_expMin ? s_expMin : (x > s_expMax ? s_expMax : x);
+    double kd = xc*s_log2e + s_round;
+    int64_t k = static_cast<int64_t>(toBits(kd) - toBits(s_round));
+    kd -= s_round;
+
+    double r = (xc - kd*s_ln2Hi) - kd*s_ln2Lo;
+
+    // Taylor series of exp(r), truncation error below 2^-58
+    double p = 	1.0/6227020800.0;
+    p = p*r + 	1.0/479001600.0;
+    p = p*r + 	1.0/39916800.0;
+    p = p*r + 	1.0/3628800.0;
+    p = p*r + 	1.0/362880.0;
+    p = p*r + 	1.0/40320.0;
+    p = p*r + 	1.0/5040.0;
+    p = p*r + 	1.0/720.0;
+    p = p*r + 	1.0/120.0;
+    p = p*r + 	1.0/24.0;
+    p = p*r + 	1.0/6.0;
+    p = p*r + 	0.5;
+    p = p*r + 	1.0;
+    p = p*r + 	1.0;
+
+    // 2^k is applied in two steps so that subnormal results are reached
+    int64_t k1 = k >> 1;
+    int64_t k2 = k - k1;
+    double y = p * fromBits(static_cast<uint64_t>(k1 + 1023) << 52)
+                 * fromBits(static_cast<uint64_t>(k2 + 1023) << 52);
+
+    y = x > s_expMax ? HUGE_VAL : y;
+    y = x < s_expMin ? 0 : y;
+    y = x != x ? x : y;
+    return y;
+}
+
+static inline double kernelExpm1(double x)
+{
+    // Taylor series of exp(x) - 1 for |x| < 1, truncation error below 2^-60
+    double p = 	1.0/2432902008176640000.0;
+    p = p*x + 	1.0/121645100408832000.0;
+    p = p*x + 	1.0/6402373705728000.0;
+    p = p*x + 	1.0/355687428096000.0;
+    p = p*x + 	1.0/20922789888000.0;
+    p = p*x + 	1.0/1307674368000.0;
+    p = p*x + 	1.0/87178291200.0;
+    p = p*x + 	1.0/6227020800.0;
+    p = p*x + 	1.0/479001600.0;
+    p = p*x + 	1.0/39916800.0;
+    p = p*x + 	1.0/3628800.0;
+    p = p*x + 	1.0/362880.0;
+    p = p*x + 	1.0/40320.0;
+    p = p*x + 	1.0/5040.0;
+    p = p*x + 	1.0/720.0;
+    p = p*x + 	1.0/120.0;
+    p = p*x + 	1.0/24.0;
+    p = p*x + 	1.0/6.0;
+    p = p*x + 	0.5;
+    p = p*x*x + x;
+
+    return fabs(x) < 1 ? p : kernelExp(x) - 1;
+}
+
+static inline double kernelLn(double x)
+{
+    // ln(x) = k*ln2 + ln(1 + f), sqrt(2)/2 <= 1 + f < sqrt(2)
+    bool flag_subnormal = x < s_minNormal;
+    double xs = flag_subnormal ? x*s_twoPow54 : x;
+    uint64_t bits = toBits(xs);
+
+    // exponent, converted to double without an integer conversion
+    double kd = fromBits((bits >> 52) | 0x4330000000000000ULL) - s_twoPow52 - 1023;
+    kd = flag_subnormal ? kd - 54 : kd;
+
+    double m = fromBits((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+    bool flag_high = m > s_sqrt2;
+    m = flag_high ? m*0.5 : m;
+    kd = flag_high ? kd + 1 : kd;
+
+    double f = m - 1;
+    double s = f/(2 + f);
+    double z = s*s;
+
+    // R(z) = 2z/3 + 2z^2/5 + ..., truncation error below 2^-60
+    double R = 	2.0/23.0;
+    R = R*z + 	2.0/21.0;
+    R = R*z + 	2.0/19.0;
+    R = R*z + 	2.0/17.0;
+    R = R*z + 	2.0/15.0;
+    R = R*z + 	2.0/13.0;
+    R = R*z + 	2.0/11.0;
+    R = R*z + 	2.0/9.0;
+    R = R*z + 	2.0/7.0;
+    R = R*z + 	2.0/5.0;
+    R = R*z + 	2.0/3.0;
+    R = R*z;
+
+    double hfsq = 0.5*f*f;
+    double y = kd*s_ln2Hi - ((hfsq - (s*(hfsq + R) + kd*s_ln2Lo)) - f);
+
+    y = x == 0 ? -HUGE_VAL : y;
+    y = x < 0 ? NAN : y;
+    y = x == HUGE_VAL ? x : y;
+    y = x != x ? x : y;
+    return y;
+}
+
+static inline double kernelLog1p(double u)
+{
+    // ln(1 + u), corrected for the rounding of 1 + u
+    double w = 1 + u;
+    double d = w - 1;
+    double y = kernelLn(w) * (u/d);
+    return d == 0 ? u : y;
+}
+
+static inline double kernelLog(double x)
+{
+    return kernelLn(x) * s_invLn10;
+}
+
+static inline double kernelSinPoly(double r, double z)
+{
+    double p = 	 1.58969099521155010221e-10;
+    p = p*z + 	-2.50507602534068634195e-08;
+    p = p*z + 	 2.75573137070700676789e-06;
+    p = p*z + 	-1.98412698298579493134e-04;
+    p = p*z + 	 8.33333333332248946124e-03;
+    p = p*z + 	-1.66666666666666324348e-01;
+    return r + r*z*p;
+}
+
+static inline double kernelCosPoly(double z)
+{
+    double p = 	-1.13596475577881948265e-11;
+    p = p*z + 	 2.08757232129817482790e-09;
+    p = p*z + 	-2.75573143513906633035e-07;
+    p = p*z + 	 2.48015872894767294178e-05;
+    p = p*z + 	-1.38888888888741095749e-03;
+    p = p*z + 	 4.16666666666666019037e-02;
+
+    double hz = 0.5*z;
+    double w = 1 - hz;
+    return w + (((1 - w) - hz) + z*z*p);
+}
+
+static inline double reduceQuadrant(double x, double &quadrant)
+{
+    // r = x - k*pi/2, quadrant = k mod 4 in the range [-2, 2]; the first
+    // three products are exact for |k| < 2^20 and their differences cancel
+    // exactly near multiples of pi/2, so the tail keeps r accurate there
+    double kd = (x*s_twoOverPi + s_round) - s_round;
+    double kd4 = (kd*0.25 + s_round) - s_round;
+    quadrant = kd - 4*kd4;
+    return (((x - kd*s_pio2_1) - kd*s_pio2_2) - kd*s_pio2_3) - kd*s_pio2_3t;
+}
+
+static inline double kernelSin(double x)
+{
+    double quadrant;
+    double r = reduceQuadrant(x, quadrant);
+    double z = r*r;
+
+    double s = kernelSinPoly(r, z);
+    double c = kernelCosPoly(z);
+
+    // quadrant 0: s, 1: c, 2: -s, 3: -c
+    double y = fabs(quadrant) == 1 ? c : s;
+    y = (quadrant < 0 || quadrant > 1.5) ? -y : y;
+    return x == 0 ? x : y;
+}
+
+static inline double kernelCos(double x)
+{
+    double quadrant;
+    double r = reduceQuadrant(x, quadrant);
+    double z = r*r;
+
+    double s = kernelSinPoly(r, z);
+    double c = kernelCosPoly(z);
+
+    // quadrant 0: c, 1: -s, 2: -c, 3: s
+    double y = fabs(quadrant) == 1 ? s : c;
+    return (quadrant > 0.5 || quadrant < -1.5) ? -y : y;
+}
+
+static inline double kernelTan(double x)
+{
+    double quadrant;
+    double r = reduceQuadrant(x, quadrant);
+    double z = r*r;
+
+    double s = kernelSinPoly(r, z);
+    double c = kernelCosPoly(z);
+
+    // even quadrants: s/c, odd quadrants: -c/s
+    double y = fabs(quadrant) == 1 ? -c/s : s/c;
+    return x == 0 ? x : y;
+}
+
+static inline double kernelArcsinR(double z)
+{
+    // rational approximation of (asin(s) - s)/s^3, z = s^2
+    double p = 	 3.47933107596021167570e-05;
+    p = p*z + 	 7.91534994289814532176e-04;
+    p = p*z + 	-4.00555345006794114027e-02;
+    p = p*z + 	 2.01212532134862925881e-01;
+    p = p*z + 	-3.25565818622400915405e-01;
+    p = p*z + 	 1.66666666666666657415e-01;
+    p = p*z;
+
+    double q = 	 7.70381505559019352791e-02;
+    q = q*z + 	-6.88283971605453293030e-01;
+    q = q*z + 	 2.02094576023350569471e+00;
+    q = q*z + 	-2.40339491173441421878e+00;
+    q = q*z + 	 1.0;
+    return p/q;
+}
+
+static inline double kernelArcsin(double x)
+{
+    // |x| <= 0.5: asin(x) directly
+    // |x| >  0.5: asin(x) = pi/2 - 2*asin(sqrt((1 - |x|)/2))
+    double a = fabs(x);
+    bool flag_small = a <= 0.5;
+    double z = flag_small ? a*a : 0.5*(1 - a);
+    double s = flag_small ? a : sqrt(z);
+    double p = s + s*kernelArcsinR(z);
+
+    double y = flag_small ? p : s_pio2Hi - (2*p - s_pio2Lo);
+    return copysign(y, x);
+}
+
+static inline double kernelArccos(double x)
+{
+    // |x| <= 0.5: acos(x) = pi/2 - asin(x)
+    //  x  >  0.5: acos(x) = 2*asin(sqrt((1 - x)/2))
+    //  x  < -0.5: acos(x) = pi - 2*asin(sqrt((1 + x)/2))
+    double a = fabs(x);
+    bool flag_small = a <= 0.5;
+    double z = flag_small ? x*x : 0.5*(1 - a);
+    double s = flag_small ? x : sqrt(z);
+    double sr = s*kernelArcsinR(z);
+
+    double y_small = s_pio2Hi - (s - (s_pio2Lo - sr));
+    double y_positive = 2*(s + sr);
+    double y_negative = s_pi - 2*(s + (sr - s_pio2Lo));
+
+    return flag_small ? y_small : (x > 0 ? y_positive : y_negative);
+}
+
+static inline double kernelArctan(double x)
+{
+    // atan(|x|) = atan(c) + atan(u), u = (|x| - c)/(1 + c*|x|), for c in {0, 0.5, 1, 1.5, inf}
+    double t = fabs(x);
+    bool flag_1 = t >= 0.4375;
+    bool flag_2 = t >= 0.6875;
+    bool flag_3 = t >= 1.1875;
+    bool flag_4 = t >= 2.4375;
+
+    double c = 0, hi = 0, lo = 0;
+    c = flag_1 ? 0.5 : c;	hi = flag_1 ? 4.63647609000806093515e-01 : hi;	lo = flag_1 ? 2.26987774529616870924e-17 : lo;
+    c = flag_2 ? 1.0 : c;	hi = flag_2 ? 7.85398163397448278999e-01 : hi;	lo = flag_2 ? 3.06161699786838301793e-17 : lo;
+    c = flag_3 ? 1.5 : c;	hi = flag_3 ? 9.82793723247329054082e-01 : hi;	lo = flag_3 ? 1.39033110312309984516e-17 : lo;
+    hi = flag_4 ? 1.57079632679489655800e+00 : hi;	lo = flag_4 ? 6.12323399573676603587e-17 : lo;
+
+    double num = flag_4 ? -1 : t - c;
+    double den = flag_4 ? t : 1 + c*t;
+
+    double u = num/den;
+    double z = u*u;
+    double w = z*z;
+
+    double s1 = 	 1.62858201153657823623e-02;
+    s1 = s1*w + 	 4.97687799461593236017e-02;
+    s1 = s1*w + 	 6.66107313738753120669e-02;
+    s1 = s1*w + 	 9.09088713343650656196e-02;
+    s1 = s1*w + 	 1.42857142725034663711e-01;
+    s1 = s1*w + 	 3.33333333333329318027e-01;
+    s1 = s1*z;
+
+    double s2 = 	-3.65315727442169155270e-02;
+    s2 = s2*w + 	-5.83357013379057348645e-02;
+    s2 = s2*w + 	-7.69187620504482999495e-02;
+    s2 = s2*w + 	-1.11111104054623557880e-01;
+    s2 = s2*w + 	-1.99999999998764832476e-01;
+    s2 = s2*w;
+
+    double y = hi - ((u*(s1 + s2) - lo) - u);
+    return copysign(y, x);
+}
+
+static inline double kernelSinh(double x)
+{
+    // sinh(|x|) = (t + t/(t + 1))/2, t = exp(|x|) - 1
+    double t = kernelExpm1(fabs(x));
+    return copysign(0.5*(t + t/(t + 1)), x);
+}
+
+static inline double kernelCosh(double x)
+{
+    double e = kernelExp(fabs(x));
+    return 0.5*e + 0.5/e;
+}
+
+static inline double kernelTanh(double x)
+{
+    // tanh(|x|) = t/(t + 2), t = exp(2|x|) - 1; tanh rounds to 1 beyond |x| = 20
+    double a = fabs(x);
+    double t = kernelExpm1(2*(a > 20 ? 20 : a));
+    double y = t/(t + 2);
+    y = a != a ? a : y;
+    return copysign(y, x);
+}
+
+static inline double kernelArcsinh(double x)
+{
+    // asinh(|x|) = ln(1 + |x| + x^2/(1 + sqrt(1 + x^2))), or ln(2|x|) for large |x|
+    double a = fabs(x);
+    double small = kernelLog1p(a + a*a/(1 + sqrt(1 + a*a)));
+    double large = kernelLn(a) + s_ln2;
+    return copysign(a > s_twoPow28 ? large : small, x);
+}
+
+static inline double kernelArccoshNear1(double t)
+{
+    // acosh(1 + t)/sqrt(2t) = sum of (-1)^n C(2n, n)/(8^n (2n + 1)) t^n, for t < 1/16
+    double p = 	 8.19368731407892096012e-06;
+    p = p*t + 	-1.90656436117071843741e-05;
+    p = p*t + 	 4.51242222505457229141e-05;
+    p = p*t + 	-1.09100341796875005421e-04;
+    p = p*t + 	 2.71136944110576935587e-04;
+    p = p*t + 	-6.99129971590909120478e-04;
+    p = p*t + 	 1.89887152777777775368e-03;
+    p = p*t + 	-5.58035714285714298105e-03;
+    p = p*t + 	 1.87499999999999993061e-02;
+    p = p*t + 	-8.33333333333333287074e-02;
+    return sqrt(2*t) + sqrt(2*t)*(p*t);
+}
+
+static inline double kernelArccosh(double x)
+{
+    // acosh(x) = ln(1 + t + sqrt(2t + t^2)), t = x - 1, or ln(2x) for large x;
+    // near 1 the logarithm loses accuracy to the rounding of its argument
+    double t = x - 1;
+    double near = kernelArccoshNear1(t);
+    double small = kernelLog1p(t + sqrt(2*t + t*t));
+    double large = kernelLn(x) + s_ln2;
+    double y = x > s_twoPow28 ? large : small;
+    y = t < 0.0625 ? near : y;
+    return x < 1 ? NAN : y;
+}
+
+static inline double kernelArctanh(double x)
+{
+    // atanh(|x|) = ln(1 + 2|x|/(1 - |x|))/2
+    double a = fabs(x);
+    double t = a + a;
+    double u = a < 0.5 ? t + t*a/(1 - a) : t/(1 - a);
+    double y = 0.5*kernelLog1p(u);
+    y = a == 1 ? HUGE_VAL : y;
+    return copysign(y, x);
+}
+
+
+///	Kernel Loops
+///	=============
+//	The fast loops are compiled once for every supported instruction set. The
+//	scalar kernels are inlined into each loop and vectorized to its width.
+
+struct KernelTable
+{
+    KernelLoop exp, ln, log;
+    KernelLoop sin, cos, tan;
+    KernelLoop sinh, cosh, tanh;
+    KernelLoop arcsin, arccos, arctan;
+    KernelLoop arcsinh, arccosh, arctanh;
+};
+
+#define KERNEL_LOOP(name, isa, target) \
+    target static void loop##name##_##isa(const double *x, double *y, int count) \
+    { for (int k = 0; k < count; k++) { y[k] = kernel##name(x[k]); } }
+
+#define KERNEL_TABLE(isa, target) \
+    KERNEL_LOOP(Exp, isa, target) \
+    KERNEL_LOOP(Ln, isa, target) \
+    KERNEL_LOOP(Log, isa, target) \
+    KERNEL_LOOP(Sin, isa, target) \
+    KERNEL_LOOP(Cos, isa, target) \
+    KERNEL_LOOP(Tan, isa, target) \
+    KERNEL_LOOP(Sinh, isa, target) \
+    KERNEL_LOOP(Cosh, isa, target) \
+    KERNEL_LOOP(Tanh, isa, target) \
+    KERNEL_LOOP(Arcsin, isa, target) \
+    KERNEL_LOOP(Arccos, isa, target) \
+    KERNEL_LOOP(Arctan, isa, target) \
+    KERNEL_LOOP(Arcsinh, isa, target) \
+    KERNEL_LOOP(Arccosh, isa, target) \
+    KERNEL_LOOP(Arctanh, isa, target) \
+    static const KernelTable s_table_##isa = { \
+        loopExp_##isa,		loopLn_##isa,		loopLog_##isa, \
+        loopSin_##isa,		loopCos_##isa,		loopTan_##isa, \
+        loopSinh_##isa,		loopCosh_##isa,		loopTanh_##isa, \
+        loopArcsin_##isa,	loopArccos_##isa,	loopArctan_##isa, \
+        loopArcsinh_##isa,	loopArccosh_##isa,	loopArctanh_##isa };
+
+KERNEL_TABLE(sse2, )
+
+#ifdef MATHKERNELS_DISPATCH
+KERNEL_TABLE(avx2, __attribute__((target("avx2,fma"))))
+KERNEL_TABLE(avx512, __attribute__((target("avx512f,avx512dq,avx2,fma,prefer-vector-width=512"))))
+#endif
+
+
+///	Static Variables
+///	=================
+
+KernelAccuracy MathKernels::s_accuracy = AccuracyExact;
+KernelIsa MathKernels::s_isa = MathKernels::detectIsa();
+const KernelTable *MathKernels::s_kernels = MathKernels::kernelTable(MathKernels::s_isa);
+
+
+///	Public Functions
+///	=================
+
+//	Settings
+//	---------
+
+void MathKernels::setAccuracy(KernelAccuracy accuracy) { s_accuracy = accuracy; }
+
+KernelAccuracy MathKernels::accuracy() { return s_accuracy; }
+
+bool MathKernels::setIsa(KernelIsa isa)
+{
+    if (!isaSupported(isa))
+        return false;
+
+    s_isa = isa;
+    s_kernels = kernelTable(isa);
+    return true;
+}
+
+KernelIsa MathKernels::isa() { return s_isa; }
+
+
+//	Instruction Sets
+//	-----------------
+
+bool MathKernels::isaSupported(KernelIsa isa)
+{
+    /*!	Checks the CPU with cpuid; the AVX checks include operating system
+        support for saving the wider registers.*/
+
+#ifdef MATHKERNELS_DISPATCH
+    __builtin_cpu_init();
+    switch(isa){
+    case IsaSSE2:	return true;
+    case IsaAVX2:	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case IsaAVX512:	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+                            && isaSupported(IsaAVX2);
+    }
+    return false;
+#else
+    return isa == IsaSSE2;
+#endif
+}
+
+KernelIsa MathKernels::detectIsa()
+{
+    if (isaSupported(IsaAVX512))	return IsaAVX512;
+    if (isaSupported(IsaAVX2))		return IsaAVX2;
+    return IsaSSE2;
+}
+
+string MathKernels::isaName(KernelIsa isa)
+{
+    switch(isa){
+    case IsaSSE2:	return "sse2";
+    case IsaAVX2:	return "avx2";
+    case IsaAVX512:	return "avx512";
+    }
+    return "";
+}
+
+bool MathKernels::isaFromName(string name, KernelIsa &isa)
+{
+    for (int i = IsaSSE2; i <= IsaAVX512; i++){
+        if (name == isaName(static_cast<KernelIsa>(i))){
+            isa = static_cast<KernelIsa>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//	Private
+//	--------
+
+const KernelTable *MathKernels::kernelTable(KernelIsa isa)
+{
+#ifdef MATHKERNELS_DISPATCH
+    switch(isa){
+    case IsaSSE2:	return &s_table_sse2;
+    case IsaAVX2:	return &s_table_avx2;
+    case IsaAVX512:	return &s_table_avx512;
+    }
+#endif
+    (void)isa;
+    return &s_table_sse2;
+}
+
+
+//	Exponential and Logarithmic
+//	----------------------------
+
+void MathKernels::vectorExp(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = exp(x[k]); }
+        return;
+    }
+    s_kernels->exp(x, y, count);
+}
+
+void MathKernels::vectorLn(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = log(x[k]); }
+        return;
+    }
+    s_kernels->ln(x, y, count);
+}
+
+void MathKernels::vectorLog(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = log10(x[k]); }
+        return;
+    }
+    s_kernels->log(x, y, count);
+}
+
+
+//	Trig
+//	-----
+
+void MathKernels::vectorSin(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = sin(x[k]); }
+        return;
+    }
+    s_kernels->sin(x, y, count);
+
+    // values outside of the fast domain
+    for (int k = 0; k < count; k++) {
+        if (!(fabs(x[k]) <= s_trigLimit)) { y[k] = sin(x[k]); }
+    }
+}
+
+void MathKernels::vectorCos(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = cos(x[k]); }
+        return;
+    }
+    s_kernels->cos(x, y, count);
+
+    // values outside of the fast domain
+    for (int k = 0; k < count; k++) {
+        if (!(fabs(x[k]) <= s_trigLimit)) { y[k] = cos(x[k]); }
+    }
+}
+
+void MathKernels::vectorTan(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = tan(x[k]); }
+        return;
+    }
+    s_kernels->tan(x, y, count);
+
+    // values outside of the fast domain
+    for (int k = 0; k < count; k++) {
+        if (!(fabs(x[k]) <= s_trigLimit)) { y[k] = tan(x[k]); }
+    }
+}
+
+
+//	Hyperbolic
+//	-----------
+
+void MathKernels::vectorSinh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = sinh(x[k]); }
+        return;
+    }
+    s_kernels->sinh(x, y, count);
+
+    // values outside of the fast domain
+    for (int k = 0; k < count; k++) {
+        if (!(fabs(x[k]) <= s_hyperLimit)) { y[k] = sinh(x[k]); }
+    }
+}
+
+void MathKernels::vectorCosh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = cosh(x[k]); }
+        return;
+    }
+    s_kernels->cosh(x, y, count);
+
+    // values outside of the fast domain
+    for (int k = 0; k < count; k++) {
+        if (!(fabs(x[k]) <= s_hyperLimit)) { y[k] = cosh(x[k]); }
+    }
+}
+
+void MathKernels::vectorTanh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = tanh(x[k]); }
+        return;
+    }
+    s_kernels->tanh(x, y, count);
+}
+
+
+//	Inverse Trig
+//	-------------
+
+void MathKernels::vectorArcsin(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = asin(x[k]); }
+        return;
+    }
+    s_kernels->arcsin(x, y, count);
+}
+
+void MathKernels::vectorArccos(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = acos(x[k]); }
+        return;
+    }
+    s_kernels->arccos(x, y, count);
+}
+
+void MathKernels::vectorArctan(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = atan(x[k]); }
+        return;
+    }
+    s_kernels->arctan(x, y, count);
+}
+
+
+//	Inverse Hyperbolic
+//	-------------------
+
+void MathKernels::vectorArcsinh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = asinh(x[k]); }
+        return;
+    }
+    s_kernels->arcsinh(x, y, count);
+}
+
+void MathKernels::vectorArccosh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = acosh(x[k]); }
+        return;
+    }
+    s_kernels->arccosh(x, y, count);
+}
+
+void MathKernels::vectorArctanh(const double *x, double *y, int count)
+{
+    if (s_accuracy == AccuracyExact){
+        for (int k = 0; k < count; k++) { y[k] = atanh(x[k]); }
+        return;
+    }
+    s_kernels->arctanh(x, y, count);
+}
@@ -101,9 +101,11 @@ void Plotus::plot()
     qRegisterMetaType<VarInputArray>("VarInputArray");
     qRegisterMetaType<IneqInputArray>("IneqInputArray");
     qRegisterMetaType<IneqLoaderArray>("IneqLoaderArray");
-    qRegisterMetaType<PlottingVector>("PlottingVector");
+    qRegisterMetaType<Region>("Region");
     qRegisterMetaType<PlotStyle>("PlotStyle");
     qRegisterMetaType<Variable>("Variable");
+    qRegisterMetaType< QList<QPolygonF> >("QList<QPolygonF>");
+    qRegisterMetaType< QVector<double> >("QVector<double>");
 
     QWidget::connect(thread, SIGNAL	(started()), worker, SLOT	(createWorker()));
 
@@ -115,10 +117,14 @@ void Plotus::plot()
                      this, SLOT		(log(QString)));
     QWidget::connect(worker, SIGNAL	(progressUpdate(int, QString)),
                      this, SLOT		(setProgress(int, QString)));
-    QWidget::connect(worker, SIGNAL	(newGraph(PlottingVector,PlotStyle,QColor, QString)),
-                     this, SLOT		(addGraph(PlottingVector, PlotStyle, QColor, QString)));
-    QWidget::connect(worker, SIGNAL	(newErrorGraph(PlottingVector)),
-                     this, SLOT		(addErrorGraph(PlottingVector)));
+    QWidget::connect(worker, SIGNAL	(newGraph(Region,PlotStyle,QColor, QString)),
+                     this, SLOT		(addGraph(Region, PlotStyle, QColor, QString)));
+    QWidget::connect(worker, SIGNAL	(newFilledGraph(QList<QPolygonF>,QColor,QString)),
+                     this, SLOT		(addFilledGraph(QList<QPolygonF>,QColor,QString)));
+    QWidget::connect(worker, SIGNAL	(newOverlay(QVector<double>,int,QRectF)),
+                     this, SLOT		(addOverlay(QVector<double>,int,QRectF)));
+    QWidget::connect(worker, SIGNAL	(newErrorGraph(Region)),
+                     this, SLOT		(addErrorGraph(Region)));
     QWidget::connect(worker, SIGNAL(memberChanges(VarInputArray,IneqInputArray,IneqLoaderArray)),
                      this, SLOT(registerMemberChanges(VarInputArray,IneqInputArray,IneqLoaderArray)));
     QWidget::connect(worker, SIGNAL	(workFinished()),
@@ -412,6 +418,18 @@ void Plotus::loadSettings()
     if (!(buffer >> m_compPrec))
         m_compPrec = 0;
 
+    //	accuracy of function evaluation
+    MathKernels::setAccuracy(static_cast<KernelAccuracy>(ui->comboBox_SettingsAccuracy->currentIndex()));
+
+    //	evaluation of inequalities
+    Inequality::setEvaluation(static_cast<InequalityEvaluation>(ui->comboBox_SettingsEvaluation->currentIndex()));
+
+    //	refinement of the boundaries of regions
+    Inequality::setRefinementDepth(ui->comboBox_SettingsRefinement->currentIndex());
+
+    //	overlay of the plotted regions
+    PlotWorker::setOverlay(static_cast<PlotOverlay>(ui->comboBox_SettingsOverlay->currentIndex()));
+
     //	directory
     m_defaultDir = QDir::currentPath();
 }
@@ -643,6 +661,10 @@ void Plotus::determineTabOrder()
     QWidget::setTabOrder(ui->toolButton_AddInequalityLoader, ui->toolButton_AddVariable);
     QWidget::setTabOrder(ui->toolButton_AddVariable, ui->pushButton_Cancel);
     QWidget::setTabOrder(ui->pushButton_Cancel, ui->lineEdit_SettingsTolerance);
+    QWidget::setTabOrder(ui->lineEdit_SettingsTolerance, ui->comboBox_SettingsAccuracy);
+    QWidget::setTabOrder(ui->comboBox_SettingsAccuracy, ui->comboBox_SettingsEvaluation);
+    QWidget::setTabOrder(ui->comboBox_SettingsEvaluation, ui->comboBox_SettingsRefinement);
+    QWidget::setTabOrder(ui->comboBox_SettingsRefinement, ui->comboBox_SettingsOverlay);
 }
 
 void Plotus::setUIMode(UIMode mode)
@@ -1076,12 +1098,12 @@ void Plotus::setProgress(int value, QString message)
     }
 }
 
-void Plotus::addGraph(PlottingVector qwt_samples, PlotStyle shape, QColor marker_color, QString tag)
+void Plotus::addGraph(Region region, PlotStyle shape, QColor marker_color, QString tag)
 {
         QwtPlotCurve *plot = new QwtPlotCurve(tag);
 
-        if (shape == QwtSymbol::UserStyle){
-            //	Dots style
+        if (shape == QwtSymbol::UserStyle || shape == s_filledStyle){
+            //	Dots style, also for filled regions which cannot be traced (see PlotWorker)
             plot->setStyle(QwtPlotCurve::Dots);
             plot->setPen(marker_color);
             plot->setRenderThreadCount(0); // ideal thread count
@@ -1097,7 +1119,7 @@ void Plotus::addGraph(PlottingVector qwt_samples, PlotStyle shape, QColor marker
         }
 
         //	set data
-        plot->setSamples(qwt_samples);
+        plot->setSamples(new RegionSeries(region, RegionPoints));
         //	add graph
         plot->attach(plotter);
         plotter->replot();
@@ -1106,7 +1128,64 @@ void Plotus::addGraph(PlottingVector qwt_samples, PlotStyle shape, QColor marker
         flag_Empty = false;
 }
 
-void Plotus::addErrorGraph(PlottingVector qwt_problem_samples)
+void Plotus::addFilledGraph(QList<QPolygonF> polygons, QColor marker_color, QString tag)
+{
+        /*!	Draws a region as the polygons of its boundary (traced by the
+            PlotWorker, see RegionContour), filled under the even-odd rule so
+            holes stay empty.*/
+
+        QPainterPath path;
+        path.setFillRule(Qt::OddEvenFill);
+        for (int i = 0; i < polygons.size(); i++){
+            path.addPolygon(polygons[i]);
+            path.closeSubpath();
+        }
+
+        QColor fill_color = marker_color;
+        fill_color.setAlpha(128);
+
+        QwtPlotShapeItem *plot = new QwtPlotShapeItem(tag);
+        plot->setItemAttribute(QwtPlotItem::Legend, true);
+        plot->setRenderHint(QwtPlotItem::RenderAntialiased, true);
+        plot->setPen(QPen(marker_color, 1));
+        plot->setBrush(fill_color);
+        plot->setShape(path);
+
+        //	add graph
+        plot->attach(plotter);
+        plotter->replot();
+
+        m_graphCount++;
+        flag_Empty = false;
+}
+
+void Plotus::addOverlay(QVector<double> values, int columns, QRectF bounds)
+{
+        /*!	Shades the plot by the slack of a region (see PlotWorker): blue
+            where it holds, red where it fails, fading to clear on its
+            boundary and saturating PlotWorker::s_overlayRange steps of the
+            grid away from it.*/
+
+        QwtMatrixRasterData *data = new QwtMatrixRasterData();
+        data->setInterval(Qt::XAxis, QwtInterval(bounds.left(), bounds.right()));
+        data->setInterval(Qt::YAxis, QwtInterval(bounds.top(), bounds.bottom()));
+        data->setInterval(Qt::ZAxis, QwtInterval(-PlotWorker::s_overlayRange, PlotWorker::s_overlayRange));
+        data->setValueMatrix(values, columns);
+
+        QwtLinearColorMap *color_map = new QwtLinearColorMap(QColor(0, 0, 255, 160), QColor(255, 0, 0, 160), QwtColorMap::RGB);
+        color_map->addColorStop(0.5, QColor(255, 255, 255, 0));
+
+        QwtPlotSpectrogram *overlay = new QwtPlotSpectrogram("Slack");
+        overlay->setRenderThreadCount(0); // ideal thread count
+        overlay->setColorMap(color_map);
+        overlay->setData(data);
+        overlay->setZ(-1);	// under the graphs
+
+        overlay->attach(plotter);
+        plotter->replot();
+}
+
+void Plotus::addErrorGraph(Region region)
 {
         QwtPlotCurve *plot = new QwtPlotCurve();
         QwtSymbol *marker = new QwtSymbol(QwtSymbol::Star1,
@@ -1117,7 +1196,7 @@ void Plotus::addErrorGraph(PlottingVector qwt_problem_samples)
         plot->setStyle(QwtPlotCurve::NoCurve);
         plot->setTitle("Problem Points");
         //	add data
-        plot->setSamples(qwt_problem_samples);
+        plot->setSamples(new RegionSeries(region, RegionProblems));
         //	add graph
         plot->attach(plotter);
         plotter->replot();
@@ -1353,6 +1432,26 @@ void Plotus::on_lineEdit_SettingsTolerance_editingFinished()
     edit->clearFocus();
 }
 
+void Plotus::on_comboBox_SettingsAccuracy_currentIndexChanged(int index)
+{
+    MathKernels::setAccuracy(static_cast<KernelAccuracy>(index));
+}
+
+void Plotus::on_comboBox_SettingsEvaluation_currentIndexChanged(int index)
+{
+    Inequality::setEvaluation(static_cast<InequalityEvaluation>(index));
+}
+
+void Plotus::on_comboBox_SettingsRefinement_currentIndexChanged(int index)
+{
+    Inequality::setRefinementDepth(index);
+}
+
+void Plotus::on_comboBox_SettingsOverlay_currentIndexChanged(int index)
+{
+    PlotWorker::setOverlay(static_cast<PlotOverlay>(index));
+}
+
 void Plotus::on_lineEdit_PlotTitle_returnPressed() { ui->container_Graph->setFocus(); }
 
 void Plotus::on_lineEdit_PlotTitle_textChanged(const QString&) { fitLineEditToContents(ui->lineEdit_PlotTitle); }
@@ -1,12 +1,17 @@
 #include "include/plotworker.h"
 
 
+///	Static Variables
+///	=================
+
+PlotOverlay PlotWorker::s_overlay = OverlayNone;
+
+
 ///	Public Functions
 ///	=================
 
 PlotWorker::PlotWorker(QObject *parent) :
     QObject(parent),
-    m_prevCombination(CombinationNone),
     m_lastMatch(0)
 {
     flag_Cancel = new bool(false);
@@ -14,44 +19,32 @@ PlotWorker::PlotWorker(QObject *parent) :
 
 void PlotWorker::doWork()
 {
-    for (int i = 0; i < m_inequalityCount + 1; i++){
-        bool skip;
-
-        for (unsigned int j = 0; j < m_inequalityInputs.size(); j++){
-            if (*flag_Cancel)
-                break;
+    planWork();
+    emit logMessage(m_errorMessage);
 
-            InequalityInput *input = m_inequalityInputs[j];
+    for (int i = 0; i < static_cast<int>(m_plan.size()); i++){
+        if (*flag_Cancel)
+            break;
 
-            if ( input->getNumber() == i ){
-                if ( input->getSkip() ) {
-                    skip = true;
-                    break;
-                }
+        const PlotStep &step = m_plan[i];
+        bool flag_combined = step.member.flag_loader ? combineOld(step) : combineNew(step);
 
-                input->setCancelPointer(flag_Cancel);
+        if (step.combination == CombinationNone)
+            m_regionMembers.clear();
+        if (flag_combined)
+            m_regionMembers.push_back(step.member);
 
-                plotNew(j);
-            }
+        if (!flag_combined){
+            // the region is incomplete: skip the rest of its combinations
+            while (i + 1 < static_cast<int>(m_plan.size()) && m_plan[i+1].combination != CombinationNone) { i++; }
+            continue;
         }
 
-        for (int j = 0; j < static_cast<int>(m_inequalityLoaders.size()); j++){
-            if (*flag_Cancel)
-                break;
-
-            InequalityLoader *loader = m_inequalityLoaders[j];
-
-            if ( loader->getNumber() == i ){
-                if ( loader->getSkip() ) {
-                    skip = true;
-                    break;
-                }
-                plotOld(j);
-            }
-        }
+        if (*flag_Cancel)
+            break;
 
-        if (*flag_Cancel) break;
-        if (skip) continue;
+        if (step.plot.index >= 0) { plotMember(step.plot); }
+        else { emit progressUpdate(100, "Done."); }	//	do not plot if combination requested
     }
 
     if (*flag_Cancel) emit progressUpdate(100, "Cancelled.");
@@ -62,6 +55,10 @@ void PlotWorker::doWork()
 
 void PlotWorker::setCancelPointer(bool *ptr){ flag_Cancel = ptr; }
 
+void PlotWorker::setOverlay(PlotOverlay overlay) { s_overlay = overlay; }
+
+PlotOverlay PlotWorker::overlay() { return s_overlay; }
+
 
 
 ///	Public Slots
@@ -94,87 +91,313 @@ void PlotWorker::workerInit(VarInputArray var_inputs,
 ///	Private Functions
 ///	==================
 
-void PlotWorker::plotNew(int gui_number)
+//	Planning
+//	---------
+
+void PlotWorker::planWork()
 {
-    InequalityInput *input = m_inequalityInputs[gui_number];
-    QString gui_number_str = QString::number(gui_number);
+    /*!	Lists the inequalities in the order of the GUI, leaving out those to
+        be skipped. Each is combined with the region of the ones before it by
+        the combination of the one before it, and the last of a region shows
+        it. The order of the evaluation within runs of intersections, unions
+        or subtractions is then chosen by reorderRun; the GUI keeps its order.*/
 
-    emit progressUpdate(0, "Evaluating inequality " + gui_number_str + "...");
-    input->setXYVariables(m_xVariable, m_yVariable);
-    if(!input->evaluate()){
-        printError();
-        return;
+    m_plan.clear();
+    for (int i = 0; i < m_inequalityCount + 1; i++){
+        for (int j = 0; j < static_cast<int>(m_inequalityInputs.size()); j++){
+            if (m_inequalityInputs[j]->getNumber() == i && !m_inequalityInputs[j]->getSkip()){
+                PlotStep step = { { false, j }, CombinationNone, { false, -1 } };
+                m_plan.push_back(step);
+            }
+        }
+        for (int j = 0; j < static_cast<int>(m_inequalityLoaders.size()); j++){
+            if (m_inequalityLoaders[j]->getNumber() == i && !m_inequalityLoaders[j]->getSkip()){
+                PlotStep step = { { true, j }, CombinationNone, { true, -1 } };
+                m_plan.push_back(step);
+            }
+        }
     }
 
-    if (*flag_Cancel)
-        return;
+    int size = static_cast<int>(m_plan.size());
+    int combination = CombinationNone;
+    for (int i = 0; i < size; i++){
+        PlotStep &step = m_plan[i];
+        step.combination = combination;
+        combination = step.member.flag_loader ? m_inequalityLoaders[step.member.index]->getCombination()
+                                              : m_inequalityInputs[step.member.index]->getCombination();
+        if (combination == CombinationNone)
+            step.plot = step.member;
+    }
 
-    emit progressUpdate(40, "Combining results, inequality " + gui_number_str + "...");
-    combineResults(input);
+    // runs of one combination; the first inequality of a region joins an intersection or union
+    for (int i = 0; i + 1 < size; ){
+        int run_combination = m_plan[i+1].combination;
+        if (run_combination == CombinationNone){
+            i++;
+            continue;
+        }
 
-    if (*flag_Cancel)
-        return;
+        int last = i + 1;
+        while (last + 1 < size && m_plan[last+1].combination == run_combination) { last++; }
 
-    m_prevCombination = input->getCombination();
-    if (m_prevCombination != CombinationNone){	//	do not plot if combination requested
-        emit progressUpdate(100, "Done.");
-        return;
+        bool flag_commutative = (run_combination != CombinationSubtract);
+        int first = (m_plan[i].combination == CombinationNone && flag_commutative) ? i : i + 1;
+        if (last > first)
+            reorderRun(first, last, run_combination);
+        i = last;
     }
+}
 
-    if (*flag_Cancel)
-        return;
+void PlotWorker::reorderRun(int first, int last, int combination)
+{
+    /*!	Orders the inequalities of steps first to last, which are combined
+        in the same way, so the cheapest evaluation removes the most work
+        from the ones after it, and logs the order. Each evaluation is masked
+        by the region before it, so the inequalities are sorted by their cost
+        per point of the mask which they settle (see estimateRank).*/
+
+    vector< pair<double, int> > ranks;
+    vector<PlotMember> members;
+    vector<QString> estimates;
+    QString gui_order;
+
+    for (int i = first; i <= last; i++){
+        QString estimate;
+        ranks.push_back(make_pair(estimateRank(m_plan[i].member, combination, estimate), i - first));
+        members.push_back(m_plan[i].member);
+        estimates.push_back(estimate);
+        gui_order += (i == first ? "" : ", ") + QString::number(memberNumber(m_plan[i].member));
+    }
+    stable_sort(ranks.begin(), ranks.end());
+
+    QString plan_order;
+    for (int i = first; i <= last; i++){
+        int k = ranks[i - first].second;
+        m_plan[i].member = members[k];
+        plan_order += (i == first ? "" : ", ") + estimates[k];
+    }
 
-    input->setX(splitPlottingVectorX(m_results));
-    input->setY(splitPlottingVectorY(m_results));
+    QString combination_name = (combination == CombinationIntersect) ? "Intersection" :
+                               (combination == CombinationUnion) ? "Union" : "Subtraction";
+    m_errorMessage += "Info | Plan | " + combination_name + " of inequalities " + gui_order
+            + ", evaluated as " + plan_order + ".\n";
+}
 
-    emit progressUpdate(80, "Plotting results, inequality " + gui_number_str + "..." );
-    emit newGraph(m_results, input->getShape(), input->getColor(), input->getName());
+double PlotWorker::estimateRank(const PlotMember &member, int combination, QString &estimate)
+{
+    /*!	An intersection only evaluates the points its region still holds,
+        so an inequality which holds in little of the grid saves the most
+        work; a union or subtraction only evaluates the points its region
+        does not settle yet, so one which holds in much of it does. The rank
+        is the cost per point divided by the part of the points settled.*/
+
+    double cost, selectivity;
+    if (member.flag_loader){
+        InequalityLoader *loader = m_inequalityLoaders[member.index];
+        loader->setPlot();
+        cost = loader->getCost();
+        selectivity = loader->getSelectivity();
+    } else {
+        InequalityInput *input = m_inequalityInputs[member.index];
+        input->setXYVariables(m_xVariable, m_yVariable);
+        cost = input->getCost();
+        selectivity = input->getSelectivity();
+    }
 
-    if (!m_resultsProblem.isEmpty())
-        emit newErrorGraph(m_resultsProblem);
+    estimate = QString::number(memberNumber(member)) + " (cost " + QString::number(cost)
+            + ", holds at " + QString::number(100*selectivity, 'f', 0) + "%)";
 
-    printWarning();
-    emit progressUpdate(100, "Done.");
-//    flag_empty = false;
+    double settled = (combination == CombinationIntersect) ? 1 - selectivity : selectivity;
+    if (cost == 0)
+        return 0;
+    return (settled > 0) ? cost/settled : numeric_limits<double>::infinity();
+}
+
+int PlotWorker::memberNumber(const PlotMember &member)
+{
+    if (member.flag_loader)
+        return m_inequalityLoaders[member.index]->getNumber() + 1;
+    return m_inequalityInputs[member.index]->getNumber() + 1;
 }
 
 
-void PlotWorker::plotOld(int gui_number)
+//	Evaluation and Plotting
+//	------------------------
+
+bool PlotWorker::combineNew(const PlotStep &step)
+{
+    InequalityInput *input = m_inequalityInputs[step.member.index];
+    QString gui_number_str = QString::number(step.member.index);
+
+    emit progressUpdate(0, "Evaluating inequality " + gui_number_str + "...");
+    input->setCancelPointer(flag_Cancel);
+    input->setXYVariables(m_xVariable, m_yVariable);
+
+    // only the points the combination can change are evaluated: those in the
+    // region for an intersection or subtraction, those outside of it for a union
+    Region complement;
+    const Region *mask = 0;
+    if (step.combination == CombinationIntersect || step.combination == CombinationSubtract)
+        mask = &m_region;
+    if (step.combination == CombinationUnion){
+        complement = m_region.complement();
+        mask = &complement;
+    }
+
+    if(!input->evaluate(mask)){
+        printError();
+        return false;
+    }
+
+    if (*flag_Cancel)
+        return false;
+
+    emit progressUpdate(40, "Combining results, inequality " + gui_number_str + "...");
+    combineResults(input, step.combination);
+    return true;
+}
+
+bool PlotWorker::combineOld(const PlotStep &step)
 {
-    InequalityLoader* loader = m_inequalityLoaders[gui_number];
-    QString gui_number_str = QString::number(gui_number);
+    InequalityLoader* loader = m_inequalityLoaders[step.member.index];
+    QString gui_number_str = QString::number(step.member.index);
 
     loader->setPlot();
 
     emit progressUpdate(40, "Combining results, inequality " + gui_number_str + "...");
-    combineResults(loader);
+    combineResults(loader, step.combination);
+    return true;
+}
+
+void PlotWorker::plotMember(const PlotMember &member)
+{
+    if (member.flag_loader) { plotResults(m_inequalityLoaders[member.index], member.index); }
+    else { plotResults(m_inequalityInputs[member.index], member.index); }
+}
+
+vector<ContourMember> PlotWorker::contourMembers()
+{
+    /*!	The inequalities combined into the region, with their own regions,
+        for the projection of its boundary (see RegionContour). None are
+        given if one was resampled onto the grid of the region, as its
+        points cannot be compared with those of the region.*/
+
+    vector<ContourMember> members;
+    for (unsigned int i = 0; i < m_regionMembers.size(); i++){
+        const PlotMember &member = m_regionMembers[i];
+        ContourMember contour_member = { 0, 0 };
+        if (member.flag_loader){
+            contour_member.region = &m_inequalityLoaders[member.index]->getRegion();
+        } else {
+            contour_member.region = &m_inequalityInputs[member.index]->getRegion();
+            contour_member.inequality = &m_inequalityInputs[member.index]->getInequality();
+        }
+
+        if (!contour_member.region->sameGrid(m_region))
+            return vector<ContourMember>();
+        members.push_back(contour_member);
+    }
+    return members;
+}
 
-    // log combination mode
-    m_prevCombination = loader->getCombination();
+QList<QPolygonF> PlotWorker::tracePolygons()
+{
+    /*!	Traces the boundary of the region, projected onto the boundaries of
+        the inequalities combined into it, as polygons of the plot.*/
+
+    RegionContour contour(m_region, contourMembers());
+    const vector<ContourPolygon> &polygons = contour.polygons();
+
+    QList<QPolygonF> plot_polygons;
+    for (unsigned int i = 0; i < polygons.size(); i++){
+        QPolygonF polygon;
+        for (unsigned int k = 0; k < polygons[i].size(); k++) { polygon << QPointF(polygons[i][k].x, polygons[i][k].y); }
+        plot_polygons.append(polygon);
+    }
 
-    // determine if need to plot
-    if (m_prevCombination != CombinationNone){
-        emit progressUpdate(100, "Done.");
+    m_errorMessage += "Info | Boundary | " + QString::number(contour.pointCount()) + " points, "
+            + QString::number(contour.projectedCount()) + " projected onto the boundaries of the inequalities.\n";
+    return plot_polygons;
+}
+
+void PlotWorker::plotOverlay()
+{
+    /*!	Samples the slack of the region on a grid of at most s_overlaySamples
+        points per side: at each point, the slack of the inequality whose
+        field is that of the region there (the one which decides the
+        combination, see Region), in steps of the grid of the region. Points
+        decided by a loaded inequality, or where the field is not known,
+        are NaN and stay clear.*/
+
+    if (m_region.width() < 2 || m_region.height() < 2 || !m_region.hasField())
         return;
+
+    vector<ContourMember> members = contourMembers();
+    for (unsigned int i = 0; i < members.size(); i++){
+        if (members[i].inequality != 0)
+            members[i].inequality->prepareBoundary();
+    }
+
+    int columns = min(m_region.width(), static_cast<int>(s_overlaySamples));
+    int rows = min(m_region.height(), static_cast<int>(s_overlaySamples));
+    double x_step = (m_region.x(m_region.width() - 1) - m_region.x(0))/(m_region.width() - 1);
+    double y_step = (m_region.y(m_region.height() - 1) - m_region.y(0))/(m_region.height() - 1);
+
+    QVector<double> values(columns*rows, NAN);
+    for (int row = 0; row < rows && !*flag_Cancel; row++){
+        int region_row = row*(m_region.height() - 1)/max(rows - 1, 1);
+        for (int column = 0; column < columns; column++){
+            int region_column = column*(m_region.width() - 1)/max(columns - 1, 1);
+            double field = m_region.field(region_column, region_row);
+
+            for (unsigned int i = 0; i < members.size(); i++){
+                double member_field = members[i].region->field(region_column, region_row);
+                if (members[i].inequality == 0 || (member_field != field && member_field != -field))
+                    continue;
+
+                double sign = (member_field == field) ? 1 : -1;	// a subtracted inequality
+                values[row*columns + column] = sign*members[i].inequality->slack(m_region.x(region_column), m_region.y(region_row), x_step, y_step);
+                break;
+            }
+        }
     }
 
-    loader->setX(splitPlottingVectorX(m_results));
-    loader->setY(splitPlottingVectorY(m_results));
+    // each value covers the part of the plot around its point
+    double x_half = 0.5*(m_region.x(m_region.width() - 1) - m_region.x(0))/max(columns - 1, 1);
+    double y_half = 0.5*(m_region.y(m_region.height() - 1) - m_region.y(0))/max(rows - 1, 1);
+    QRectF bounds(m_region.x(0) - x_half, m_region.y(0) - y_half,
+                  m_region.x(m_region.width() - 1) - m_region.x(0) + 2*x_half, m_region.y(m_region.height() - 1) - m_region.y(0) + 2*y_half);
+    emit newOverlay(values, columns, bounds);
+}
+
+template<typename T>
+void PlotWorker::plotResults(T *inequality, int gui_number)
+{
+    emit progressUpdate(80, "Plotting results, inequality " + QString::number(gui_number) + "..." );
+
+    // the region of the inequality is replaced by the combination only after
+    // the boundary and overlay, which need the regions of the members
+    if (s_overlay == OverlaySlack)
+        plotOverlay();
+
+    if (inequality->getShape() == s_filledStyle && RegionContour::canTrace(m_region))
+        emit newFilledGraph(tracePolygons(), inequality->getColor(), inequality->getName());
+    else
+        emit newGraph(m_region, inequality->getShape(), inequality->getColor(), inequality->getName());
 
-    emit progressUpdate(80, "Plotting results, inequality " + gui_number_str + "..." );
-    emit newGraph(m_results, loader->getShape(), loader->getColor(), loader->getName());
+    inequality->setRegion(m_region);
 
-    if (!m_resultsProblem.isEmpty())
-        emit newErrorGraph(m_resultsProblem);
+    if (m_region.problemCount() > 0)
+        emit newErrorGraph(m_region);
 
     printWarning();
     emit progressUpdate(100, "Done.");
 }
 
 template<typename T>
-void PlotWorker::combineResults(T *inequality)
+void PlotWorker::combineResults(T *inequality, int combination)
 {
-    switch(m_prevCombination){
+    switch(combination){
     case CombinationNone:
         combinationNone(inequality);
         break;
@@ -195,90 +418,58 @@ void PlotWorker::combineResults(T *inequality)
 template<typename T>
 void PlotWorker::combinationNone(T *inequality)
 {
-        m_results = createPlottingVector(inequality->getX(), inequality->getY());
-        m_resultsProblem = createPlottingVector(inequality->getXProblem(), inequality->getYProblem());
+        m_region = inequality->getRegion();
 }
 
 template<typename T>
 void PlotWorker::combinationIntersection(T *inequality)
 {
-    PlottingVector old_results = m_results;
-    PlottingVector new_results = createPlottingVector(inequality->getX(), inequality->getY());
-    m_results.clear();
-
-    PlottingVector *smallest = old_results.count() < new_results.count() ? &old_results : &new_results;
-    PlottingVector *biggest = old_results.count() > new_results.count() ? &old_results : &new_results;
-
-    for (int i = 0; i < smallest->count(); i++){
-        if ( biggest->contains(smallest->at(i)) )
-            m_results << smallest->at(i);
-    }
+    Region resampled;
+    m_region.intersect(alignedRegion(inequality, resampled));
+    logCombination("Intersection");
 }
 
 template<typename T>
 void PlotWorker::combinationUnion(T *inequality)
 {
-    PlottingVector old_results = m_results;
-    PlottingVector new_results = createPlottingVector(inequality->getX(), inequality->getY());
-    m_results.clear();
-
-    PlottingVector *smallest = old_results.count() < new_results.count() ? &old_results : &new_results;
-    PlottingVector *biggest = old_results.count() > new_results.count() ? &old_results : &new_results;
-
-    for (int i = 0; i < smallest->count(); i++){
-        if ( biggest->contains(smallest->at(i)) )
-            continue;
-        m_results << smallest->at(i);
-    }
-    for (int i = 0; i < biggest->count(); i++){
-        m_results << biggest->at(i);
-    }
+    Region resampled;
+    m_region.unite(alignedRegion(inequality, resampled));
+    logCombination("Union");
 }
 
 template<typename T>
 void PlotWorker::combinationSubtraction(T *inequality)
 {
-    PlottingVector old_results = m_results;
-    PlottingVector new_results = createPlottingVector(inequality->getX(), inequality->getY());
-    m_results.clear();
-
-    for (int i = 0; i < old_results.count(); i++){
-        if (new_results.contains(old_results.at(i)))
-            continue;
-        m_results << old_results.at(i);
-    }
-
+    Region resampled;
+    m_region.subtract(alignedRegion(inequality, resampled));
+    logCombination("Subtraction");
 }
 
-PlottingVector PlotWorker::createPlottingVector(QVector<double> x_values, QVector<double> y_values)
+template<typename T>
+const Region &PlotWorker::alignedRegion(T *inequality, Region &resampled)
 {
-   PlottingVector points;
+    /*!	Returns the region of the inequality on the grid of the combined
+        region, so the two can be combined a word at a time. The region is
+        only copied, into resampled, if it is on a different grid.*/
 
-   for (int i = 0; i < x_values.count(); i++){
-       points << QPointF(x_values[i], y_values[i]);
-   }
+    const Region &region = inequality->getRegion();
+    if (region.sameGrid(m_region))
+        return region;
 
-   return points;
+    resampled = region.resampled(m_region.xVariable(), m_region.yVariable(), m_region.height());
+    return resampled;
 }
 
-QVector<double> PlotWorker::splitPlottingVectorX(PlottingVector points){
-    QVector<double> x_values;
-
-    for (int i = 0; i < points.count(); i++){
-        x_values << points[i].x();
-    }
-
-    return x_values;
-}
-
-QVector<double> PlotWorker::splitPlottingVectorY(PlottingVector points){
-    QVector<double> y_values;
-
-    for (int i = 0; i < points.count(); i++){
-        y_values << points[i].y();
-    }
-
-    return y_values;
+void PlotWorker::logCombination(QString combination)
+{
+    int points = m_region.count();
+    int grid_points = m_region.width()*m_region.height();
+    double percentage = (grid_points > 0) ? 100.0*points/grid_points : 0.0;
+
+    m_errorMessage += "Info | Combination | " + combination + ": "
+            + QString::number(points) + " of " + QString::number(grid_points) + " points ("
+            + QString::number(percentage, 'f', 1) + "%), "
+            + QString::number(m_region.problemCount()) + " problem points.\n";
 }
 
 void PlotWorker::printError()
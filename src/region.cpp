@@ -0,0 +1,642 @@
+#include"include/region.h"
+
+
+//	Constructors
+//	-------------
+
+Region::Region() :
+    m_Width(0),
+    m_Height(0),
+    m_WordsPerRow(0),
+    m_Refinement(1)
+{ }
+
+Region::Region(const Variable &x_variable, const Variable &y_variable, int height) :
+    m_xVariable(x_variable),
+    m_yVariable(y_variable),
+    m_Width(x_variable.domainSize()),
+    m_Height(height < 0 ? y_variable.domainSize() : height),
+    m_Refinement(1)
+{
+    /*!	Creates an empty region on the grid of x_variable and y_variable. If
+        height is given, the grid has that many rows; the values of
+        y_variable then repeat every y_variable.domainSize() rows.*/
+
+    m_WordsPerRow = (m_Width + s_wordBits - 1)/s_wordBits;
+    m_Points.assign(m_WordsPerRow*m_Height, 0);
+    m_Problems.assign(m_WordsPerRow*m_Height, 0);
+}
+
+
+//	Grid
+//	-----
+
+double Region::x(int column) const { return m_xVariable.value(column); }
+
+double Region::y(int row) const { return m_yVariable.value(row % m_yVariable.domainSize()); }
+
+bool Region::sameGrid(const Region &other) const
+{
+    const Variable *variables[2] = { &m_xVariable, &m_yVariable };
+    const Variable *other_variables[2] = { &other.m_xVariable, &other.m_yVariable };
+
+    if (m_Width != other.m_Width || m_Height != other.m_Height)
+        return false;
+
+    for (int i = 0; i < 2; i++){
+        const Variable &a = *variables[i];
+        const Variable &b = *other_variables[i];
+        if (a.domainSize() != b.domainSize() || a.domainSpacing() != b.domainSpacing())
+            return false;
+        if (a.domainSize() > 0 && (a.value(0) != b.value(0) || a.value(a.domainSize()-1) != b.value(b.domainSize()-1)))
+            return false;
+    }
+    return true;
+}
+
+
+//	Points
+//	-------
+
+int Region::count() const { return countBits(m_Points); }
+
+int Region::problemCount() const
+{
+    /*!	Counts the problem points of the grid, and the problem sub-points of
+        the refined cells other than the points of the grid.*/
+
+    int total = countBits(m_Problems);
+    for (unsigned int i = 0; i < m_Cells.size(); i++) { total += bitCount(m_Cells[i].problems & ~RegionWord(1)); }
+    return total;
+}
+
+bool Region::testBit(const vector<RegionWord> &bits, int column, int row) const
+{
+    assert(column >= 0 && column < m_Width && row >= 0 && row < m_Height && "Region: Point outside of the grid");
+    return (bits[row*m_WordsPerRow + column/s_wordBits] >> (column % s_wordBits)) & 1;
+}
+
+void Region::setBit(vector<RegionWord> &bits, int column, int row, bool flag)
+{
+    assert(column >= 0 && column < m_Width && row >= 0 && row < m_Height && "Region: Point outside of the grid");
+
+    RegionWord &word = bits[row*m_WordsPerRow + column/s_wordBits];
+    RegionWord bit = RegionWord(1) << (column % s_wordBits);
+    word = flag ? (word | bit) : (word & ~bit);
+}
+
+void Region::setRectangle(int first_column, int first_row, int columns, int rows)
+{
+    /*!	Sets the points of columns x rows points from (first_column,
+        first_row), a word of each row at a time.*/
+
+    assert(first_column >= 0 && first_column + columns <= m_Width && first_row >= 0 && first_row + rows <= m_Height && "Region: Rectangle outside of the grid");
+    if (columns <= 0)
+        return;
+
+    int first_word = first_column/s_wordBits;
+    int last_word = (first_column + columns - 1)/s_wordBits;
+    RegionWord first_mask = ~RegionWord(0) << (first_column % s_wordBits);
+    int end_bits = (first_column + columns) % s_wordBits;
+    RegionWord last_mask = (end_bits == 0) ? ~RegionWord(0) : (RegionWord(1) << end_bits) - 1;
+
+    for (int row = first_row; row < first_row + rows; row++){
+        RegionWord *points = pointRow(row);
+        for (int w = first_word; w <= last_word; w++){
+            RegionWord word = ~RegionWord(0);
+            if (w == first_word) { word &= first_mask; }
+            if (w == last_word) { word &= last_mask; }
+            points[w] |= word;
+        }
+    }
+}
+
+bool Region::containsAny(int first_column, int first_row, int columns, int rows) const
+{
+    /*!	Returns true if any of the columns x rows points from (first_column,
+        first_row) is in the region, testing a word of each row at a time.*/
+
+    assert(first_column >= 0 && first_column + columns <= m_Width && first_row >= 0 && first_row + rows <= m_Height && "Region: Rectangle outside of the grid");
+    if (columns <= 0)
+        return false;
+
+    int first_word = first_column/s_wordBits;
+    int last_word = (first_column + columns - 1)/s_wordBits;
+    RegionWord first_mask = ~RegionWord(0) << (first_column % s_wordBits);
+    int end_bits = (first_column + columns) % s_wordBits;
+    RegionWord last_mask = (end_bits == 0) ? ~RegionWord(0) : (RegionWord(1) << end_bits) - 1;
+
+    for (int row = first_row; row < first_row + rows; row++){
+        const RegionWord *points = pointRow(row);
+        for (int w = first_word; w <= last_word; w++){
+            RegionWord word = points[w];
+            if (w == first_word) { word &= first_mask; }
+            if (w == last_word) { word &= last_mask; }
+            if (word != 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+int Region::countBits(const vector<RegionWord> &bits) const
+{
+    int total = 0;
+    for (unsigned int i = 0; i < bits.size(); i++) { total += bitCount(bits[i]); }
+    return total;
+}
+
+
+//	Refinement
+//	-----------
+
+void Region::setRefinement(int refinement)
+{
+    /*!	Sets the number of sub-points per side of a refined cell, a power of
+        2 of at most s_maxRefinement, and removes the refined cells.*/
+
+    assert(refinement >= 1 && refinement <= s_maxRefinement && (refinement & (refinement - 1)) == 0 && "Region: Invalid refinement");
+    m_Refinement = refinement;
+    m_Cells.clear();
+}
+
+void Region::addCell(const RegionCell &cell)
+{
+    /*!	Adds a refined cell. Cells are added in the order of their index, and
+        only between points of the grid.*/
+
+    assert(m_Refinement > 1 && "Region: Adding a cell to a region which is not refined");
+    assert(cell.index % m_Width < m_Width - 1 && cell.index/m_Width < m_Height - 1 && "Region: Cell outside of the grid");
+    assert((m_Cells.empty() || m_Cells.back().index < cell.index) && "Region: Cells added out of order");
+    assert(((cell.points | cell.problems) & ~cellMask(m_Refinement)) == 0 && "Region: Sub-point outside of the cell");
+
+    m_Cells.push_back(cell);
+}
+
+RegionCell Region::cell(int index, int refinement) const
+{
+    /*!	Returns the cell of index with refinement sub-points per side, which
+        must be at least the refinement of the region. A cell which is not
+        refined holds the value of its point at each sub-point.*/
+
+    assert(refinement >= m_Refinement && "Region: Cells are not coarsened");
+
+    RegionCell cell = { index, 0, 0 };
+    int low = 0, high = static_cast<int>(m_Cells.size());
+    while (low < high){
+        int middle = (low + high)/2;
+        if (m_Cells[middle].index < index) { low = middle + 1; }
+        else { high = middle; }
+    }
+
+    if (low < static_cast<int>(m_Cells.size()) && m_Cells[low].index == index){
+        cell.points = rescaledCell(m_Cells[low].points, m_Refinement, refinement, true);
+        cell.problems = rescaledCell(m_Cells[low].problems, m_Refinement, refinement, false);
+        return cell;
+    }
+
+    int column = index % m_Width;
+    int row = index/m_Width;
+    cell.points = contains(column, row) ? cellMask(refinement) : 0;
+    cell.problems = isProblem(column, row) ? 1 : 0;
+    return cell;
+}
+
+double Region::subX(int column, int sub) const { return subValue(m_xVariable, column, sub); }
+
+double Region::subY(int row, int sub) const { return subValue(m_yVariable, row % m_yVariable.domainSize(), sub); }
+
+double Region::subValue(const Variable &variable, int index, int sub) const
+{
+    /*!	Returns the value of sub-point sub, from 0 to refinement, between
+        value index and the next value of variable: evenly spaced for a
+        linear domain, and in equal ratios for a logarithmic one.*/
+
+    if (sub == 0)
+        return variable.value(index);
+    if (sub == m_Refinement)
+        return variable.value(index + 1);
+
+    double first = variable.value(index);
+    double next = variable.value(index + 1);
+    double fraction = static_cast<double>(sub)/m_Refinement;
+    if (variable.domainSpacing() == Logarithmic)
+        return first*pow(next/first, fraction);
+    return first + (next - first)*fraction;
+}
+
+RegionWord Region::cellMask(int refinement)
+{
+    int bits = refinement*refinement;
+    return (bits == s_wordBits) ? ~RegionWord(0) : (RegionWord(1) << bits) - 1;
+}
+
+RegionWord Region::rescaledCell(RegionWord bits, int from, int to, bool flag_fill)
+{
+    /*!	Maps the sub-points of a cell of from sub-points per side onto a cell
+        of to sub-points per side. With flag_fill, each sub-point fills the
+        block of sub-points it stands for, otherwise only the first.*/
+
+    if (from == to)
+        return bits;
+
+    int ratio = to/from;
+    RegionWord rescaled = 0;
+    for (; bits != 0; bits &= bits - 1){
+        int bit = lowestBit(bits);
+        int i = (bit % from)*ratio;
+        int j = (bit/from)*ratio;
+        int size = flag_fill ? ratio : 1;
+        for (int dj = 0; dj < size; dj++){
+            for (int di = 0; di < size; di++) { rescaled |= RegionWord(1) << ((j + dj)*to + i + di); }
+        }
+    }
+    return rescaled;
+}
+
+
+//	Field
+//	------
+
+void Region::enableField()
+{
+    /*!	Keeps a field for the points of the grid, unknown (NaN) until set.*/
+
+    m_Field.assign(m_Width*m_Height, NAN);
+}
+
+double Region::field(int column, int row) const
+{
+    assert(column >= 0 && column < m_Width && row >= 0 && row < m_Height && "Region: Point outside of the grid");
+    return hasField() ? m_Field[row*m_Width + column] : NAN;
+}
+
+float Region::pointField(int index) const
+{
+    // without a field, the value of a point is only its side of the boundary
+    if (hasField())
+        return m_Field[index];
+    return ((m_Points[(index/m_Width)*m_WordsPerRow + (index % m_Width)/s_wordBits] >> (index % m_Width % s_wordBits)) & 1) ? -1.0f : 1.0f;
+}
+
+void Region::combineField(const Region &other, float (*combine)(float, float))
+{
+    /*!	Combines the fields of the regions if either has one; a region
+        without a field takes -1 at its points and 1 elsewhere. Unknown
+        values are left out of the combination (fmin and fmax pass over
+        NaN). Must be called before the points of the grid are combined.*/
+
+    if (!hasField() && !other.hasField())
+        return;
+
+    vector<float> field(m_Width*m_Height);
+    for (int i = 0, n = m_Width*m_Height; i < n; i++) { field[i] = combine(pointField(i), other.pointField(i)); }
+    m_Field.swap(field);
+}
+
+
+//	Combination
+//	------------
+
+void Region::intersect(const Region &other)
+{
+    /*!	Keeps the points which are also in other. The problem points of
+        both regions are kept. The regions must share their grid.*/
+
+    assert(sameGrid(other) && "Region: Combining regions on different grids");
+    combineCells(other, intersectWords);
+    combineField(other, intersectFields);
+
+    RegionWord *points = m_Points.data();
+    const RegionWord *other_points = other.m_Points.data();
+    for (size_t i = 0, n = m_Points.size(); i < n; i++) { points[i] &= other_points[i]; }
+
+    uniteProblems(other);
+}
+
+void Region::unite(const Region &other)
+{
+    /*!	Adds the points of other. The problem points of both regions are
+        kept. The regions must share their grid.*/
+
+    assert(sameGrid(other) && "Region: Combining regions on different grids");
+    combineCells(other, uniteWords);
+    combineField(other, uniteFields);
+
+    RegionWord *points = m_Points.data();
+    const RegionWord *other_points = other.m_Points.data();
+    for (size_t i = 0, n = m_Points.size(); i < n; i++) { points[i] |= other_points[i]; }
+
+    uniteProblems(other);
+}
+
+void Region::subtract(const Region &other)
+{
+    /*!	Removes the points of other. The problem points of both regions are
+        kept. The regions must share their grid.*/
+
+    assert(sameGrid(other) && "Region: Combining regions on different grids");
+    combineCells(other, subtractWords);
+    combineField(other, subtractFields);
+
+    RegionWord *points = m_Points.data();
+    const RegionWord *other_points = other.m_Points.data();
+    for (size_t i = 0, n = m_Points.size(); i < n; i++) { points[i] &= ~other_points[i]; }
+
+    uniteProblems(other);
+}
+
+void Region::clip(const Region &mask)
+{
+    /*!	Keeps only the points, problem points and field values at the points
+        of mask; the field is unknown elsewhere. Unlike intersect, the problem
+        points of mask are not added. The regions must share their grid, and
+        the region must not be refined yet.*/
+
+    assert(sameGrid(mask) && "Region: Combining regions on different grids");
+    assert(m_Cells.empty() && "Region: Clipping a refined region");
+
+    const RegionWord *active = mask.m_Points.data();
+    for (size_t i = 0, n = m_Points.size(); i < n; i++){
+        m_Points[i] &= active[i];
+        m_Problems[i] &= active[i];
+    }
+
+    if (!hasField())
+        return;
+    for (int row = 0; row < m_Height; row++){
+        float *field = fieldRow(row);
+        for (int column = 0; column < m_Width; column++){
+            if (!mask.contains(column, row))
+                field[column] = NAN;
+        }
+    }
+}
+
+void Region::excludeProblems()
+{
+    /*!	Removes the problem points, and the problem sub-points of the
+        refined cells, from the points of the region; they stay problem
+        points.*/
+
+    for (size_t i = 0, n = m_Points.size(); i < n; i++) { m_Points[i] &= ~m_Problems[i]; }
+    for (unsigned int i = 0; i < m_Cells.size(); i++) { m_Cells[i].points &= ~m_Cells[i].problems; }
+}
+
+Region Region::complement() const
+{
+    /*!	Returns the points of the grid which are not in the region, without
+        problem points, and the field with its sign changed. The padding bits
+        stay 0.*/
+
+    Region region(m_xVariable, m_yVariable, m_Height);
+    if (region.isEmpty())
+        return region;
+
+    int last_bits = m_Width % s_wordBits;
+    RegionWord last_mask = (last_bits == 0) ? ~RegionWord(0) : (RegionWord(1) << last_bits) - 1;
+
+    for (int row = 0; row < m_Height; row++){
+        const RegionWord *points = pointRow(row);
+        RegionWord *complement = region.pointRow(row);
+        for (int w = 0; w < m_WordsPerRow; w++) { complement[w] = ~points[w]; }
+        complement[m_WordsPerRow-1] &= last_mask;
+    }
+
+    region.m_Field = m_Field;
+    for (unsigned int i = 0; i < region.m_Field.size(); i++) { region.m_Field[i] = -region.m_Field[i]; }
+
+    region.m_Refinement = m_Refinement;
+    for (unsigned int i = 0; i < m_Cells.size(); i++){
+        RegionCell cell = { m_Cells[i].index, ~m_Cells[i].points & cellMask(m_Refinement), 0 };
+        region.m_Cells.push_back(cell);
+    }
+    return region;
+}
+
+void Region::uniteProblems(const Region &other)
+{
+    RegionWord *problems = m_Problems.data();
+    const RegionWord *other_problems = other.m_Problems.data();
+    for (size_t i = 0, n = m_Problems.size(); i < n; i++) { problems[i] |= other_problems[i]; }
+}
+
+void Region::combineCells(const Region &other, RegionWord (*combine)(RegionWord, RegionWord))
+{
+    /*!	Combines the cells refined in either region, at the finer of the two
+        refinements. Must be called before the points of the grid are
+        combined, as the cells which are not refined are read from them.*/
+
+    int refinement = max(m_Refinement, other.m_Refinement);
+    if (refinement == 1)
+        return;
+
+    vector<RegionCell> cells;
+    unsigned int i = 0, j = 0;
+    while (i < m_Cells.size() || j < other.m_Cells.size()){
+        int index;
+        if (j == other.m_Cells.size() || (i < m_Cells.size() && m_Cells[i].index < other.m_Cells[j].index)) { index = m_Cells[i++].index; }
+        else if (i == m_Cells.size() || other.m_Cells[j].index < m_Cells[i].index) { index = other.m_Cells[j++].index; }
+        else { index = m_Cells[i++].index; j++; }
+
+        RegionCell a = cell(index, refinement);
+        RegionCell b = other.cell(index, refinement);
+        RegionCell combined = { index, combine(a.points, b.points) & cellMask(refinement), a.problems | b.problems };
+        cells.push_back(combined);
+    }
+
+    m_Refinement = refinement;
+    m_Cells.swap(cells);
+}
+
+
+//	Conversion
+//	-----------
+
+Region Region::resampled(const Variable &x_variable, const Variable &y_variable, int height) const
+{
+    /*!	Maps the region onto the grid of x_variable and y_variable (with
+        height rows, as in the constructor): each point of the new grid takes
+        the bits of the nearest point of this grid, and is empty if it lies
+        outside of this grid. The field is mapped in the same way; refined
+        cells are not kept.*/
+
+    Region region(x_variable, y_variable, height);
+    if (isEmpty())
+        return region;
+    if (hasField())
+        region.enableField();
+
+    vector<int> columns(region.m_Width);
+    for (int column = 0; column < region.m_Width; column++) { columns[column] = nearestIndex(m_xVariable, region.x(column)); }
+
+    for (int row = 0; row < region.m_Height; row++){
+        int source_row = nearestIndex(m_yVariable, region.y(row));
+        if (source_row < 0 || source_row >= m_Height)
+            continue;
+
+        for (int column = 0; column < region.m_Width; column++){
+            if (columns[column] < 0)
+                continue;
+            region.setPoint(column, row, contains(columns[column], source_row));
+            region.setProblem(column, row, isProblem(columns[column], source_row));
+            if (hasField())
+                region.m_Field[row*region.m_Width + column] = m_Field[source_row*m_Width + columns[column]];
+        }
+    }
+    return region;
+}
+
+int Region::nearestIndex(const Variable &variable, double value)
+{
+    /*!	Returns the index of the value of the variable nearest to value, or
+        -1 if value lies more than half a step outside of its domain. The
+        values of a domain are monotonic, so they are bisected.*/
+
+    int size = variable.domainSize();
+    if (size == 0)
+        return -1;
+    if (size == 1)
+        return (value == variable.value(0)) ? 0 : -1;
+
+    bool flag_ascending = variable.value(0) <= variable.value(size-1);
+    int low = 0;
+    int high = size - 1;
+    while (high - low > 1){
+        int middle = (low + high)/2;
+        if ((variable.value(middle) <= value) == flag_ascending) { low = middle; }
+        else { high = middle; }
+    }
+
+    double low_distance = fabs(value - variable.value(low));
+    double high_distance = fabs(value - variable.value(high));
+    int nearest = (low_distance <= high_distance) ? low : high;
+
+    // outside of the domain
+    double half_step = fabs(variable.value(high) - variable.value(low))/2;
+    if (fabs(value - variable.value(nearest)) > half_step)
+        return -1;
+    return nearest;
+}
+
+
+//	Saving
+//	-------
+
+string Region::toRuns(const vector<RegionWord> &bits) const
+{
+    /*!	Writes the points of the grid, row by row, as the lengths of the
+        alternating runs of unset and set points, starting with unset points,
+        e.g. "3 2 5" for 3 unset, 2 set and 5 unset points.*/
+
+    stringstream runs;
+    bool flag_set = false;
+    int run = 0;
+
+    for (int row = 0; row < m_Height; row++){
+        const RegionWord *words = &bits[row*m_WordsPerRow];
+        for (int column = 0; column < m_Width; column++){
+            bool flag_bit = (words[column/s_wordBits] >> (column % s_wordBits)) & 1;
+            if (flag_bit != flag_set){
+                runs << run << ' ';
+                flag_set = flag_bit;
+                run = 0;
+            }
+            run++;
+        }
+    }
+    runs << run;
+    return runs.str();
+}
+
+bool Region::fromRuns(const string &runs, vector<RegionWord> &bits) const
+{
+    /*!	Reads the format of toRuns. Returns false if the runs do not cover
+        the grid exactly.*/
+
+    stringstream buffer(runs);
+    int point_count = m_Width*m_Height;
+    int point = 0;
+    bool flag_set = false;
+    int run;
+
+    bits.assign(m_WordsPerRow*m_Height, 0);
+    while (buffer >> run){
+        if (run < 0 || run > point_count - point)
+            return false;
+
+        if (flag_set){
+            for (int end = point + run; point < end; point++){
+                int row = point/m_Width;
+                int column = point % m_Width;
+                bits[row*m_WordsPerRow + column/s_wordBits] |= RegionWord(1) << (column % s_wordBits);
+            }
+        } else {
+            point += run;
+        }
+        flag_set = !flag_set;
+    }
+    return point == point_count;
+}
+
+
+string Region::cellsToString() const
+{
+    /*!	Writes the refined cells as their index, points and problem points,
+        e.g. "12 15 0 40 8 0" for two cells.*/
+
+    stringstream cells;
+    for (unsigned int i = 0; i < m_Cells.size(); i++){
+        cells << (i == 0 ? "" : " ") << m_Cells[i].index << ' ' << m_Cells[i].points << ' ' << m_Cells[i].problems;
+    }
+    return cells.str();
+}
+
+bool Region::cellsFromString(const string &cells)
+{
+    /*!	Reads the format of cellsToString, once the refinement is set.
+        Returns false if a cell is not a cell of the grid, or is out of
+        order.*/
+
+    stringstream buffer(cells);
+    RegionCell cell;
+    m_Cells.clear();
+
+    while (buffer >> cell.index){
+        if (!(buffer >> cell.points >> cell.problems) || m_Refinement == 1)
+            return false;
+        if (cell.index < 0 || cell.index % m_Width >= m_Width - 1 || cell.index/m_Width >= m_Height - 1)
+            return false;
+        if ((!m_Cells.empty() && m_Cells.back().index >= cell.index) || ((cell.points | cell.problems) & ~cellMask(m_Refinement)) != 0)
+            return false;
+        m_Cells.push_back(cell);
+    }
+    return buffer.eof();
+}
+
+
+//	Bits
+//	-----
+
+int Region::bitCount(RegionWord word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word != 0; word &= word - 1) { count++; }
+    return count;
+#endif
+}
+
+int Region::lowestBit(RegionWord word)
+{
+    assert(word != 0 && "Region: No bit is set");
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    for (; (word & 1) == 0; word >>= 1) { bit++; }
+    return bit;
+#endif
+}
@@ -0,0 +1,349 @@
+#include"include/regioncontour.h"
+
+
+///	Static Variables
+///	=================
+
+namespace
+{
+    bool cellBefore(const RegionCell &cell, int index) { return cell.index < index; }
+
+    // sides of a cell crossed by the boundary, for each set of corners in the region
+    // (bit k for corner k); corners 0 to 3 run (column, row), (column+1, row),
+    // (column+1, row+1), (column, row+1), and side k runs from corner k to the next.
+    // -1 ends the list; the saddles 5 and 10 are resolved in traceCells
+    const int s_cellSides[16][4] = {
+        { -1, -1, -1, -1 },	{ 3, 0, -1, -1 },	{ 0, 1, -1, -1 },	{ 3, 1, -1, -1 },
+        { 1, 2, -1, -1 },	{ -1, -1, -1, -1 },	{ 0, 2, -1, -1 },	{ 3, 2, -1, -1 },
+        { 2, 3, -1, -1 },	{ 0, 2, -1, -1 },	{ -1, -1, -1, -1 },	{ 1, 2, -1, -1 },
+        { 1, 3, -1, -1 },	{ 0, 1, -1, -1 },	{ 3, 0, -1, -1 },	{ -1, -1, -1, -1 },
+    };
+}
+
+
+//	Constructors
+//	-------------
+
+RegionContour::RegionContour(const Region &region, const vector<ContourMember> &members) :
+    m_region(region),
+    m_Members(members),
+    m_Refinement(region.refinement()),
+    m_SampleWidth((region.width() - 1)*region.refinement() + 1),
+    m_SampleHeight((region.height() - 1)*region.refinement() + 1),
+    m_PaddedWidth(m_SampleWidth + 2),
+    m_ProjectedCount(0),
+    m_SpreadRow(-1)
+{
+    /*!	Traces the boundary of region, projected onto the boundaries of its
+        members if given; see canTrace.*/
+
+    if (!canTrace(region))
+        return;
+
+    for (unsigned int i = 0; i < m_Members.size(); i++){
+        assert(m_Members[i].region->sameGrid(region) && "RegionContour: Members must be on the grid of the region");
+        if (m_Members[i].inequality != 0)
+            m_Members[i].inequality->prepareBoundary();
+    }
+
+    traceCells();
+    linkSegments();
+
+    m_Segments.clear();
+    m_SideSegments.clear();
+}
+
+
+//	Getters
+//	--------
+
+bool RegionContour::canTrace(const Region &region)
+{
+    /*!	The boundary of a region can be traced if it has two dimensions and
+        its rows do not repeat (see Region).*/
+
+    return region.width() >= 2 && region.height() >= 2 && region.height() == region.yVariable().domainSize();
+}
+
+int RegionContour::pointCount() const
+{
+    int count = 0;
+    for (unsigned int i = 0; i < m_Polygons.size(); i++) { count += static_cast<int>(m_Polygons[i].size()); }
+    return count;
+}
+
+
+//	Tracing
+//	--------
+
+void RegionContour::traceCells()
+{
+    /*!	Finds the segments of the boundary in each cell of the padded grid,
+        a word of cells at a time: only cells whose corners differ are
+        classified. Cell (column, row) of the padded grid has the padded
+        points (column, row) to (column+1, row+1); padded point (column, row)
+        is sample (column-1, row-1) of the region (see sampleRow).
+
+        Side ids are 2*(row*m_PaddedWidth + column) for the side from padded
+        point (column, row) to the next in x, and that plus 1 for the side to
+        the next in y.*/
+
+    int padded_height = m_SampleHeight + 2;
+    int words = (m_PaddedWidth + Region::s_wordBits - 1)/Region::s_wordBits;
+    vector<RegionWord> rows[2] = { vector<RegionWord>(words), vector<RegionWord>(words) };
+    paddedRow(0, rows[0]);
+
+    for (int row = 0; row + 1 < padded_height; row++){
+        paddedRow(row + 1, rows[1]);
+        const RegionWord *bottom = rows[0].data();
+        const RegionWord *top = rows[1].data();
+
+        for (int w = 0; w < words; w++){
+            // corner (column+1) of each column, shifted onto the column
+            RegionWord bottom_next = (bottom[w] >> 1) | ((w + 1 < words) ? bottom[w+1] << (Region::s_wordBits - 1) : 0);
+            RegionWord top_next = (top[w] >> 1) | ((w + 1 < words) ? top[w+1] << (Region::s_wordBits - 1) : 0);
+            RegionWord flips = (bottom[w] ^ bottom_next) | (bottom[w] ^ top[w]) | (bottom[w] ^ top_next);
+
+            for (; flips != 0; flips &= flips - 1){
+                int bit = Region::lowestBit(flips);
+                int column = w*Region::s_wordBits + bit;
+                int corners = static_cast<int>((bottom[w] >> bit) & 1) | static_cast<int>(((bottom_next >> bit) & 1) << 1)
+                        | static_cast<int>(((top_next >> bit) & 1) << 2) | static_cast<int>(((top[w] >> bit) & 1) << 3);
+
+                int point = row*m_PaddedWidth + column;
+                int sides[4] = { 2*point, 2*(point + 1) + 1, 2*(point + m_PaddedWidth), 2*point + 1 };
+
+                if (corners == 5 || corners == 10){
+                    // a saddle: the centre joins the two corners in the region, or separates them
+                    bool flag_joined = centreInside(column, row);
+                    bool flag_first = (corners == 5) == flag_joined;
+                    addSegment(sides[flag_first ? 0 : 3], sides[flag_first ? 1 : 0]);
+                    addSegment(sides[flag_first ? 2 : 1], sides[flag_first ? 3 : 2]);
+                    continue;
+                }
+
+                addSegment(sides[s_cellSides[corners][0]], sides[s_cellSides[corners][1]]);
+            }
+        }
+        rows[0].swap(rows[1]);
+    }
+}
+
+void RegionContour::addSegment(int side_a, int side_b)
+{
+    int segment = static_cast<int>(m_Segments.size());
+    m_Segments.push_back(make_pair(side_a, side_b));
+
+    int sides[2] = { side_a, side_b };
+    for (int k = 0; k < 2; k++){
+        unordered_map<int, pair<int, int> >::iterator it = m_SideSegments.find(sides[k]);
+        if (it == m_SideSegments.end()) { m_SideSegments[sides[k]] = make_pair(segment, -1); }
+        else { it->second.second = segment; }
+    }
+}
+
+void RegionContour::linkSegments()
+{
+    /*!	Joins the segments into polygons. Every crossed side is crossed by
+        the segments of the two cells it borders, so following the segments
+        from side to side returns to the first side.*/
+
+    vector<bool> flag_used(m_Segments.size(), false);
+    for (unsigned int first = 0; first < m_Segments.size(); first++){
+        if (flag_used[first])
+            continue;
+
+        ContourPolygon polygon;
+        int segment = static_cast<int>(first);
+        int start = m_Segments[first].first;
+        int side = m_Segments[first].second;
+        polygon.push_back(crossing(start));
+        flag_used[first] = true;
+
+        while (side != start){
+            polygon.push_back(crossing(side));
+
+            const pair<int, int> &segments = m_SideSegments[side];
+            segment = (segments.first == segment) ? segments.second : segments.first;
+            assert(segment >= 0 && "RegionContour: Boundary is not closed");
+            flag_used[segment] = true;
+            side = (m_Segments[segment].first == side) ? m_Segments[segment].second : m_Segments[segment].first;
+        }
+        m_Polygons.push_back(polygon);
+    }
+}
+
+void RegionContour::paddedRow(int row, vector<RegionWord> &bits)
+{
+    /*!	Writes the points of padded row row, the row of samples below it
+        moved one column up, or none for the rows around the grid.*/
+
+    fill(bits.begin(), bits.end(), 0);
+    if (row < 1 || row > m_SampleHeight)
+        return;
+
+    const RegionWord *points = sampleRow(row - 1);
+    int words = (m_SampleWidth + Region::s_wordBits - 1)/Region::s_wordBits;
+    for (int w = 0; w < words; w++){
+        bits[w] |= points[w] << 1;
+        if (w + 1 < static_cast<int>(bits.size()))
+            bits[w+1] |= points[w] >> (Region::s_wordBits - 1);
+    }
+}
+
+const RegionWord *RegionContour::sampleRow(int row)
+{
+    /*!	Returns the samples of a row of the traced grid as bits. Without
+        refinement, the samples are the points of the region. With
+        refinement r, sample (column, row) is sub-point (column % r, row % r)
+        of the cell of point (column/r, row/r), so the boundary is traced
+        through the refined cells at their resolution; cells which are not
+        refined repeat their point. Each row of points is spread out once,
+        for the r rows of samples of its cells.*/
+
+    if (m_Refinement == 1)
+        return m_region.pointRow(row);
+
+    int words = (m_SampleWidth + Region::s_wordBits - 1)/Region::s_wordBits;
+    int point_row = row/m_Refinement;
+    int sub = row % m_Refinement;
+    if (m_SpreadRow != point_row){
+        // each point covers the samples of its cell, the last only itself
+        m_SpreadPoints.assign(words, 0);
+        const RegionWord *points = m_region.pointRow(point_row);
+        for (int w = 0; w < m_region.wordsPerRow(); w++){
+            for (RegionWord bits = points[w]; bits != 0; bits &= bits - 1){
+                int column = w*Region::s_wordBits + Region::lowestBit(bits);
+                int count = (column + 1 < m_region.width()) ? m_Refinement : 1;
+                for (int i = 0; i < count; i++) { setSample(m_SpreadPoints, column*m_Refinement + i, true); }
+            }
+        }
+        m_SpreadRow = point_row;
+    }
+
+    m_SampleBits = m_SpreadPoints;
+    const vector<RegionCell> &cells = m_region.cells();
+    int first_index = point_row*m_region.width();
+    vector<RegionCell>::const_iterator cell = lower_bound(cells.begin(), cells.end(), first_index, cellBefore);
+    for (; cell != cells.end() && cell->index < first_index + m_region.width(); ++cell){
+        int column = cell->index - first_index;
+        for (int i = 0; i < m_Refinement; i++) { setSample(m_SampleBits, column*m_Refinement + i, (cell->points >> (sub*m_Refinement + i)) & 1); }
+    }
+    return m_SampleBits.data();
+}
+
+void RegionContour::setSample(vector<RegionWord> &bits, int column, bool flag)
+{
+    RegionWord bit = RegionWord(1) << (column % Region::s_wordBits);
+    if (flag) { bits[column/Region::s_wordBits] |= bit; }
+    else { bits[column/Region::s_wordBits] &= ~bit; }
+}
+
+bool RegionContour::sampleInside(const Region &region, int column, int row) const
+{
+    // sample (column, row) of the traced grid in region, which is on the same grid
+    int i = column % m_Refinement, j = row % m_Refinement;
+    if (i == 0 && j == 0)
+        return region.contains(column/m_Refinement, row/m_Refinement);
+    RegionCell cell = region.cell((row/m_Refinement)*region.width() + column/m_Refinement, m_Refinement);
+    return (cell.points >> (j*m_Refinement + i)) & 1;
+}
+
+double RegionContour::sampleX(int column) const { return m_region.subX(column/m_Refinement, column % m_Refinement); }
+
+double RegionContour::sampleY(int row) const { return m_region.subY(row/m_Refinement, row % m_Refinement); }
+
+bool RegionContour::centreInside(int column, int row) const
+{
+    // the corners of a saddle are samples of the region (see traceCells); the
+    // field is only known at its points, so refined saddles are separated
+    if (m_Refinement > 1)
+        return false;
+
+    double sum = 0;
+    for (int k = 0; k < 4; k++){
+        double value = m_region.field(column - 1 + (k % 2), row - 1 + k/2);
+        if (value - value != 0)
+            return false;	// unknown or infinite: the corners are separated
+        sum += value;
+    }
+    return sum < 0;
+}
+
+ContourPoint RegionContour::crossing(int side)
+{
+    /*!	Returns the point at which the boundary crosses side. Next to a
+        point around the grid, it is the sample of the grid; otherwise the
+        point at which the field, interpolated linearly along the side,
+        changes sign, or the middle of the side, then projected onto the
+        boundary of a member (see projectCrossing).*/
+
+    int point = side/2;
+    int columns[2] = { point % m_PaddedWidth - 1, point % m_PaddedWidth - 1 };
+    int rows[2] = { point/m_PaddedWidth - 1, point/m_PaddedWidth - 1 };
+    if (side % 2 == 0) { columns[1]++; }
+    else { rows[1]++; }
+
+    bool flag_grid[2];
+    for (int k = 0; k < 2; k++) { flag_grid[k] = columns[k] >= 0 && columns[k] < m_SampleWidth && rows[k] >= 0 && rows[k] < m_SampleHeight; }
+
+    if (!flag_grid[0] || !flag_grid[1]){
+        int k = flag_grid[0] ? 0 : 1;
+        ContourPoint edge = { sampleX(columns[k]), sampleY(rows[k]) };
+        return edge;
+    }
+
+    // the field is known at the points of the grid, the samples of an unrefined grid
+    double fraction = 0.5;
+    if (m_Refinement == 1){
+        double first = m_region.field(columns[0], rows[0]);
+        double second = m_region.field(columns[1], rows[1]);
+        if (first - first == 0 && second - second == 0 && first != second){
+            double root = first/(first - second);
+            if (root >= 0 && root <= 1)
+                fraction = root;
+        }
+    }
+    projectCrossing(columns, rows, fraction);
+
+    double x0 = sampleX(columns[0]), y0 = sampleY(rows[0]);
+    ContourPoint point_crossing = { x0 + (sampleX(columns[1]) - x0)*fraction, y0 + (sampleY(rows[1]) - y0)*fraction };
+    return point_crossing;
+}
+
+void RegionContour::projectCrossing(const int *columns, const int *rows, double &fraction)
+{
+    /*!	Moves fraction onto the boundary of the only member which holds at
+        one point of the side and not at the other. The side is left as it
+        is if no member or more than one changes along it, or if the member is
+        loaded. A member with a field which is unknown at either point was
+        not evaluated there (see Inequality::evaluate), so does not count.*/
+
+    int changed = -1;
+    for (unsigned int i = 0; i < m_Members.size(); i++){
+        const Region &member = *m_Members[i].region;
+        if (member.refinement() > m_Refinement)
+            return;
+        if (sampleInside(member, columns[0], rows[0]) == sampleInside(member, columns[1], rows[1]))
+            continue;
+
+        // a member is evaluated at a sample if it is at the point of its cell
+        double first = member.field(columns[0]/m_Refinement, rows[0]/m_Refinement);
+        double second = member.field(columns[1]/m_Refinement, rows[1]/m_Refinement);
+        if (member.hasField() && (first - first != 0 || second - second != 0))
+            continue;
+        if (changed >= 0)
+            return;
+        changed = static_cast<int>(i);
+    }
+
+    if (changed < 0 || m_Members[changed].inequality == 0)
+        return;
+
+    double projected = fraction;
+    if (m_Members[changed].inequality->projectOnBoundary(sampleX(columns[0]), sampleY(rows[0]),
+                                                        sampleX(columns[1]), sampleY(rows[1]), projected)){
+        fraction = projected;
+        m_ProjectedCount++;
+    }
+}
@@ -0,0 +1,117 @@
+#include "include/regionseries.h"
+#include <algorithm>
+
+
+RegionSeries::RegionSeries(const Region &region, RegionLayer layer) :
+    m_region(region),
+    m_layer(layer)
+{
+    int words = m_region.wordsPerRow();
+    int first_row = -1, last_row = -1;
+    int first_column = m_region.width(), last_column = -1;
+
+    m_WordStart.assign(words*m_region.height() + 1, 0);
+    for (int y = 0; y < m_region.height(); y++){
+        const RegionWord *bits = row(y);
+        int count = 0;
+
+        for (int w = 0; w < words; w++){
+            int word = y*words + w;
+            m_WordStart[word+1] = m_WordStart[word] + Region::bitCount(bits[w]);
+            count += Region::bitCount(bits[w]);
+        }
+        if (count == 0)
+            continue;
+
+        // first and last columns, from the first and last words with a point
+        int first_word = 0, last_word = words - 1;
+        while (bits[first_word] == 0) { first_word++; }
+        while (bits[last_word] == 0) { last_word--; }
+
+        RegionWord last = bits[last_word];
+        while ((last & (last - 1)) != 0) { last &= last - 1; }
+
+        first_column = std::min(first_column, first_word*Region::s_wordBits + Region::lowestBit(bits[first_word]));
+        last_column = std::max(last_column, last_word*Region::s_wordBits + Region::lowestBit(last));
+        first_row = (first_row < 0) ? y : first_row;
+        last_row = y;
+    }
+
+    // sub-points of the refined cells, other than the points of the grid
+    const std::vector<RegionCell> &cells = m_region.cells();
+    m_CellStart.assign(cells.size() + 1, m_WordStart.back());
+    for (unsigned int i = 0; i < cells.size(); i++){
+        int count = Region::bitCount(cellBits(i));
+        m_CellStart[i+1] = m_CellStart[i] + count;
+        if (count == 0)
+            continue;
+
+        // the cell reaches to the next point in x and y
+        int column = cells[i].index % m_region.width();
+        int row = cells[i].index/m_region.width();
+        first_column = std::min(first_column, column);
+        last_column = std::max(last_column, column + 1);
+        first_row = (first_row < 0) ? row : std::min(first_row, row);
+        last_row = std::max(last_row, row + 1);
+    }
+
+    // bounding rectangle of the samples
+    if (last_row >= 0){
+        double x0 = m_region.x(first_column), x1 = m_region.x(last_column);
+        double y0 = m_region.y(first_row), y1 = m_region.y(last_row);
+        d_boundingRect = QRectF(std::min(x0, x1), std::min(y0, y1), fabs(x1 - x0), fabs(y1 - y0));
+    } else {
+        d_boundingRect = QRectF(1.0, 1.0, -2.0, -2.0);	// invalid, as for an empty series
+    }
+}
+
+size_t RegionSeries::size() const { return m_CellStart.back(); }
+
+QRectF RegionSeries::boundingRect() const { return d_boundingRect; }
+
+QPointF RegionSeries::sample(size_t i) const
+{
+    /*!	Finds the word holding sample i, then clears the bits of the samples
+        before it in that word. The samples of the points of the grid come
+        first, then the sub-points of the refined cells.*/
+
+    if (static_cast<int>(i) >= m_WordStart.back())
+        return subSample(static_cast<int>(i));
+
+    int word = static_cast<int>(std::upper_bound(m_WordStart.begin(), m_WordStart.end(), static_cast<int>(i)) - m_WordStart.begin()) - 1;
+    int y = word/m_region.wordsPerRow();
+    int w = word % m_region.wordsPerRow();
+
+    RegionWord bits = row(y)[w];
+    for (int remaining = static_cast<int>(i) - m_WordStart[word]; remaining > 0; remaining--) { bits &= bits - 1; }
+
+    int column = w*Region::s_wordBits + Region::lowestBit(bits);
+    return QPointF(m_region.x(column), m_region.y(y));
+}
+
+const RegionWord *RegionSeries::row(int y) const
+{
+    return (m_layer == RegionProblems) ? m_region.problemRow(y) : m_region.pointRow(y);
+}
+
+QPointF RegionSeries::subSample(int i) const
+{
+    int cell = static_cast<int>(std::upper_bound(m_CellStart.begin(), m_CellStart.end(), i) - m_CellStart.begin()) - 1;
+
+    RegionWord bits = cellBits(cell);
+    for (int remaining = i - m_CellStart[cell]; remaining > 0; remaining--) { bits &= bits - 1; }
+
+    int index = m_region.cells()[cell].index;
+    int sub = Region::lowestBit(bits);
+    int refinement = m_region.refinement();
+    return QPointF(m_region.subX(index % m_region.width(), sub % refinement),
+                   m_region.subY(index/m_region.width(), sub/refinement));
+}
+
+RegionWord RegionSeries::cellBits(int cell) const
+{
+    // sub-point 0 is the point of the grid, a sample of its own
+    const RegionCell &region_cell = m_region.cells()[cell];
+    RegionWord bits = (m_layer == RegionProblems) ? region_cell.problems : region_cell.points;
+    return bits & ~RegionWord(1);
+}